@@ -0,0 +1,455 @@
+/*
+  ==============================================================================
+
+    PitchBench: speed and accuracy of the pitch detectors.
+
+    Every detector is run over every test signal at every combination of
+    sample rate, window and hop, and one CSV row per run goes to stdout:
+
+        detector,signal,sample_rate,window,hop,frames,ns_per_frame,
+        gross_pitch_error,voicing_accuracy,fine_error_cents
+
+    gross_pitch_error is the share of frames voiced in both the reference
+    and the estimate that are more than 20% off. fine_error_cents is the
+    mean error of the rest. voicing_accuracy is the share of all frames
+    where the detector agreed with the reference on whether there was a
+    pitch at all. Estimates outside 20 Hz - 3 kHz, the range VocalBox acts
+    on, count as no pitch.
+
+    Options (lists are comma separated):
+        --rates=44100,48000,96000   --windows=1024,2048   --hops=256,1024
+        --seconds=2                 --detectors=Yin,AutoCorrelation,...
+        --recorded=<folder>         every name.wav in it that has a name.f0
+                                    beside it, holding "seconds hz" lines
+                                    (0 Hz for unvoiced), is run at its own
+                                    rate as well
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../../../Source/DSP/PitchDetector/AutoCorrelationDetector.h"
+#include "../../../Source/DSP/PitchDetector/MpmDetector.h"
+#include "../../../Source/DSP/PitchDetector/PYinDetector.h"
+#include "../../../Source/DSP/PitchDetector/Yin.h"
+
+namespace
+{
+    constexpr double minFrequency = 20.0;
+    constexpr double maxFrequency = 3000.0;
+    constexpr double grossErrorRatio = 0.2;
+
+    // A test signal and its pitch at every sample, 0 where unvoiced
+    struct Signal
+    {
+        juce::String name;
+        double sampleRate = 48000.0;
+        std::vector<float> samples;
+        std::vector<float> pitch;
+    };
+
+    struct Config
+    {
+        double sampleRate;
+        int windowSize;
+        int hopSize;
+    };
+
+    //==============================================================================
+    // Each detector is fed the signal one hop at a time. analyse() returns a
+    // frequency, or -1, for the audio up to end, and the sample it describes.
+    struct Detector
+    {
+        virtual ~Detector() = default;
+        virtual juce::String getName() const = 0;
+        virtual void prepare(const Config& config) = 0;
+        virtual double analyse(const float* samples, juce::int64 end, juce::int64& centre) = 0;
+
+        // Samples needed before the first analysis
+        virtual int getFrameSize(const Config& config) const { return config.windowSize; }
+    };
+
+    // pYIN at the full rate
+    struct YinDetector : Detector
+    {
+        juce::String getName() const override { return "Yin"; }
+
+        void prepare(const Config& config) override
+        {
+            juce::dsp::ProcessSpec spec{ config.sampleRate, static_cast<juce::uint32> (config.windowSize), 1 };
+            yin.prepare(spec);
+            yin.SetHopSize(static_cast<size_t> (config.hopSize));
+            windowSize = config.windowSize;
+            hopSize = config.hopSize;
+        }
+
+        int getFrameSize(const Config& config) const override { return 2 * config.windowSize; }
+
+        double analyse(const float* samples, juce::int64 end, juce::int64& centre) override
+        {
+            const double frequency = yin.Pitch(samples + end - 2 * windowSize);
+
+            // The difference function integrates over the frame's first half
+            centre = end - 3 * windowSize / 2 - static_cast<juce::int64> (yin.GetDecodeDelay()) * hopSize;
+            return frequency;
+        }
+
+        Yin::Yin_Pitch yin;
+        int windowSize = 0, hopSize = 0;
+    };
+
+    // Anything behind the PitchDetector interface, as PitchAnalyser runs it
+    template <typename DetectorType>
+    struct StreamingDetector : Detector
+    {
+        template <typename... Args>
+        StreamingDetector(juce::String nameToUse, Args&&... args)
+            : name(std::move(nameToUse)), detector(std::forward<Args>(args)...) {}
+
+        juce::String getName() const override { return name; }
+
+        void prepare(const Config& config) override
+        {
+            detector.prepare(config.sampleRate, config.windowSize, config.hopSize);
+            pushed = 0;
+        }
+
+        int getFrameSize(const Config& config) const override { return 2 * config.windowSize; }
+
+        double analyse(const float* samples, juce::int64 end, juce::int64& centre) override
+        {
+            detector.pushSamples(samples + pushed, static_cast<int> (end - pushed));
+            pushed = end;
+
+            centre = end - detector.getLatencyInSamples();
+            return detector.getEstimate().frequency;
+        }
+
+        juce::String name;
+        DetectorType detector;
+        juce::int64 pushed = 0;
+    };
+
+    // AutoCorrelation with one of its find functions
+    struct FindFunctionDetector : Detector
+    {
+        enum class Method { direct, simdNote, fftNote };
+
+        FindFunctionDetector(juce::String nameToUse, Method methodToUse)
+            : name(std::move(nameToUse)), method(methodToUse) {}
+
+        juce::String getName() const override { return name; }
+
+        void prepare(const Config& config) override
+        {
+            autoCorrelation = std::make_unique<AutoCorrelation>();
+            autoCorrelation->windowSizePower2 = juce::roundToInt(std::log2(config.windowSize));
+            autoCorrelation->hoppingSize = config.hopSize;
+            autoCorrelation->prepare(config.sampleRate, config.hopSize);
+            windowSize = config.windowSize;
+            pushed = 0;
+        }
+
+        double analyse(const float* samples, juce::int64 end, juce::int64& centre) override
+        {
+            autoCorrelation->pushSamples(samples + pushed, static_cast<int> (end - pushed));
+            pushed = end;
+            centre = end - windowSize / 2;
+
+            switch (method)
+            {
+                case Method::direct:    return autoCorrelation->getFrequency();
+                case Method::simdNote:  return noteToFrequency(autoCorrelation->SIMDfindNote());
+                case Method::fftNote:   return noteToFrequency(autoCorrelation->FFTfindNote());
+            }
+            return -1.0;
+        }
+
+        static double noteToFrequency(int note)
+        {
+            return note < 0 ? -1.0 : 440.0 * std::exp2((note - 69) / 12.0);
+        }
+
+        juce::String name;
+        Method method;
+        std::unique_ptr<AutoCorrelation> autoCorrelation; // big arrays inside
+        int windowSize = 0;
+        juce::int64 pushed = 0;
+    };
+
+    //==============================================================================
+    // Voiced in the middle, quiet noise for the first and last quarter second
+    template <typename Generator>
+    Signal makeSignal(const juce::String& name, double sampleRate, double seconds, Generator&& generate)
+    {
+        Signal signal;
+        signal.name = name;
+        signal.sampleRate = sampleRate;
+
+        const auto length = static_cast<size_t> (seconds * sampleRate);
+        signal.samples.resize(length);
+        signal.pitch.resize(length);
+
+        std::mt19937 random(1);
+        std::normal_distribution<float> noise(0.0f, 0.003f);
+        const auto quiet = static_cast<size_t> (0.25 * sampleRate);
+
+        double phase = 0.0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            const double t = i / sampleRate;
+            float value = noise(random);
+
+            if (i >= quiet && i + quiet < length)
+            {
+                double frequency = 0.0;
+                value += generate(t, phase, frequency, random);
+                signal.pitch[i] = static_cast<float> (frequency);
+                phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+            }
+
+            signal.samples[i] = value;
+        }
+
+        return signal;
+    }
+
+    // Sum of harmonics below Nyquist, each scaled by gain(k)
+    template <typename Gain>
+    float harmonics(double phase, double frequency, double sampleRate, int maxHarmonic, Gain&& gain)
+    {
+        double sum = 0.0;
+        for (int k = 1; k <= maxHarmonic && k * frequency < 0.45 * sampleRate; ++k)
+            sum += gain(k) * std::sin(k * phase);
+        return static_cast<float> (sum);
+    }
+
+    std::vector<Signal> makeSyntheticSignals(double sampleRate, double seconds)
+    {
+        using std::sin;
+        const double twoPi = juce::MathConstants<double>::twoPi;
+        std::vector<Signal> signals;
+
+        signals.push_back(makeSignal("sine", sampleRate, seconds, [](double, double phase, double& frequency, auto&)
+        {
+            frequency = 220.0;
+            return static_cast<float> (0.5 * std::sin(phase));
+        }));
+
+        signals.push_back(makeSignal("saw_vibrato", sampleRate, seconds, [=](double t, double phase, double& frequency, auto&)
+        {
+            frequency = 180.0 * std::exp2(0.5 / 12.0 * sin(twoPi * 5.5 * t));
+            return 0.3f * harmonics(phase, frequency, sampleRate, 64, [](int k) { return 1.0 / k; });
+        }));
+
+        // A glottal-like source through three /a/ formants, gliding an octave,
+        // with jitter and noise 10 dB down
+        signals.push_back(makeSignal("noisy_vocal", sampleRate, seconds, [=](double t, double phase, double& frequency, auto& random)
+        {
+            std::normal_distribution<double> jitter(0.0, 0.003);
+            std::normal_distribution<float> breath(0.0f, 0.03f);
+            frequency = 150.0 * std::exp2(t / seconds) * std::exp2(0.3 / 12.0 * sin(twoPi * 5.0 * t)) * (1.0 + jitter(random));
+
+            const auto formant = [frequency](int k)
+            {
+                double gain = 0.0;
+                for (const auto& [centre, width] : { std::pair{ 800.0, 80.0 }, std::pair{ 1150.0, 90.0 }, std::pair{ 2900.0, 120.0 } })
+                {
+                    const double d = (k * frequency - centre) / width;
+                    gain += 1.0 / (1.0 + d * d);
+                }
+                return gain / (k * k) * 4.0 + 0.5 / (k * k);
+            };
+
+            return 0.1f * harmonics(phase, frequency, sampleRate, 40, formant) + breath(random);
+        }));
+
+        // Pitch at 110 Hz with no energy there at all
+        signals.push_back(makeSignal("octave_missing_fundamental", sampleRate, seconds, [=](double, double phase, double& frequency, auto&)
+        {
+            frequency = 110.0;
+            return 0.15f * harmonics(phase, frequency, sampleRate, 5, [](int k) { return k == 1 ? 0.0 : 1.0; });
+        }));
+
+        // A weak fundamental under a strong octave
+        signals.push_back(makeSignal("octave_strong_second", sampleRate, seconds, [](double, double phase, double& frequency, auto&)
+        {
+            frequency = 196.0;
+            return static_cast<float> (0.1 * std::sin(phase) + 0.4 * std::sin(2.0 * phase + 0.5));
+        }));
+
+        return signals;
+    }
+
+    std::vector<Signal> loadRecordedSignals(const juce::File& folder)
+    {
+        std::vector<Signal> signals;
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        for (const auto& file : folder.findChildFiles(juce::File::findFiles, false, "*.wav"))
+        {
+            const auto annotation = file.withFileExtension("f0");
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+            if (reader == nullptr || ! annotation.existsAsFile())
+            {
+                std::cerr << "skipping " << file.getFullPathName() << std::endl;
+                continue;
+            }
+
+            Signal signal;
+            signal.name = file.getFileNameWithoutExtension();
+            signal.sampleRate = reader->sampleRate;
+
+            const auto length = static_cast<int> (reader->lengthInSamples);
+            juce::AudioBuffer<float> buffer(1, length);
+            reader->read(&buffer, 0, length, 0, true, false);
+            signal.samples.assign(buffer.getReadPointer(0), buffer.getReadPointer(0) + length);
+
+            // Each annotation holds until the next
+            signal.pitch.assign(static_cast<size_t> (length), 0.0f);
+            juce::StringArray lines;
+            annotation.readLines(lines);
+            for (int i = 0; i < lines.size(); ++i)
+            {
+                const auto fields = juce::StringArray::fromTokens(lines[i], " \t,", "");
+                if (fields.size() < 2)
+                    continue;
+
+                const auto start = juce::jlimit(0, length, juce::roundToInt(fields[0].getDoubleValue() * signal.sampleRate));
+                std::fill(signal.pitch.begin() + start, signal.pitch.end(), fields[1].getFloatValue());
+            }
+
+            signals.push_back(std::move(signal));
+        }
+
+        return signals;
+    }
+
+    //==============================================================================
+    void run(Detector& detector, const Signal& signal, const Config& config)
+    {
+        const auto length = static_cast<juce::int64> (signal.samples.size());
+        const auto frameSize = detector.getFrameSize(config);
+        if (length < frameSize)
+            return;
+
+        detector.prepare(config);
+
+        int frames = 0, bothVoiced = 0, gross = 0, voicingCorrect = 0, evaluated = 0;
+        double fineCents = 0.0;
+        std::chrono::nanoseconds elapsed{ 0 };
+
+        for (juce::int64 end = frameSize; end <= length; end += config.hopSize)
+        {
+            juce::int64 centre = 0;
+            const auto start = std::chrono::steady_clock::now();
+            const double estimate = detector.analyse(signal.samples.data(), end, centre);
+            elapsed += std::chrono::steady_clock::now() - start;
+            ++frames;
+
+            if (centre < 0 || centre >= length)
+                continue;
+
+            const double reference = signal.pitch[static_cast<size_t> (centre)];
+            const bool referenceVoiced = reference > 0.0;
+            const bool estimateVoiced = estimate >= minFrequency && estimate <= maxFrequency;
+
+            ++evaluated;
+            voicingCorrect += referenceVoiced == estimateVoiced ? 1 : 0;
+
+            if (referenceVoiced && estimateVoiced)
+            {
+                ++bothVoiced;
+                if (std::abs(estimate / reference - 1.0) > grossErrorRatio)
+                    ++gross;
+                else
+                    fineCents += std::abs(1200.0 * std::log2(estimate / reference));
+            }
+        }
+
+        const auto ratio = [](double a, int b) { return b > 0 ? a / b : 0.0; };
+
+        std::cout << detector.getName() << ',' << signal.name << ',' << config.sampleRate << ','
+                  << config.windowSize << ',' << config.hopSize << ',' << frames << ','
+                  << juce::roundToInt(ratio(static_cast<double> (elapsed.count()), frames)) << ','
+                  << ratio(gross, bothVoiced) << ',' << ratio(voicingCorrect, evaluated) << ','
+                  << ratio(fineCents, bothVoiced - gross) << std::endl;
+    }
+
+    template <typename T>
+    std::vector<T> parseList(const juce::ArgumentList& args, const juce::String& option, std::vector<T> defaults)
+    {
+        if (! args.containsOption(option))
+            return defaults;
+
+        std::vector<T> values;
+        for (const auto& token : juce::StringArray::fromTokens(args.getValueForOption(option), ",", ""))
+            values.push_back(static_cast<T> (token.getDoubleValue()));
+        return values;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const juce::ArgumentList args(argc, argv);
+
+    const auto rates = parseList<double>(args, "--rates", { 44100.0, 48000.0, 96000.0 });
+    const auto windows = parseList<int>(args, "--windows", { 1024, 2048 });
+    const auto hops = parseList<int>(args, "--hops", { 256, 1024 });
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+
+    std::vector<std::unique_ptr<Detector>> detectors;
+    detectors.push_back(std::make_unique<YinDetector>());
+    detectors.push_back(std::make_unique<StreamingDetector<PYinDetector>>("PYinDetector"));
+    detectors.push_back(std::make_unique<StreamingDetector<AutoCorrelationDetector>>("AutoCorrelationFFT", AutoCorrelation::fftFunction));
+    detectors.push_back(std::make_unique<StreamingDetector<AutoCorrelationDetector>>("AutoCorrelationSliding", AutoCorrelation::slidingFunction));
+    detectors.push_back(std::make_unique<StreamingDetector<MpmDetector>>("MpmDetector"));
+    detectors.push_back(std::make_unique<FindFunctionDetector>("AutoCorrelation", FindFunctionDetector::Method::direct));
+    detectors.push_back(std::make_unique<FindFunctionDetector>("SIMDfindNote", FindFunctionDetector::Method::simdNote));
+    detectors.push_back(std::make_unique<FindFunctionDetector>("FFTfindNote", FindFunctionDetector::Method::fftNote));
+
+    if (args.containsOption("--detectors"))
+    {
+        const auto wanted = juce::StringArray::fromTokens(args.getValueForOption("--detectors"), ",", "");
+        detectors.erase(std::remove_if(detectors.begin(), detectors.end(),
+                                       [&wanted](const auto& d) { return ! wanted.contains(d->getName()); }),
+                        detectors.end());
+    }
+
+    std::cout << "detector,signal,sample_rate,window,hop,frames,ns_per_frame,"
+                 "gross_pitch_error,voicing_accuracy,fine_error_cents" << std::endl;
+
+    const auto runAll = [&](const std::vector<Signal>& signals, double sampleRate)
+    {
+        for (const auto windowSize : windows)
+        {
+            // AutoCorrelation needs a power of two no bigger than 8192
+            if (! juce::isPowerOfTwo(windowSize) || windowSize > 8192)
+                continue;
+
+            for (const auto hopSize : hops)
+            {
+                if (hopSize > windowSize)
+                    continue;
+
+                for (auto& detector : detectors)
+                    for (const auto& signal : signals)
+                        run(*detector, signal, { sampleRate, windowSize, hopSize });
+            }
+        }
+    };
+
+    for (const auto sampleRate : rates)
+        runAll(makeSyntheticSignals(sampleRate, seconds), sampleRate);
+
+    if (args.containsOption("--recorded"))
+        for (auto& signal : loadRecordedSignals(juce::File(args.getValueForOption("--recorded"))))
+            runAll({ signal }, signal.sampleRate);
+
+    return 0;
+}
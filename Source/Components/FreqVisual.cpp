@@ -39,7 +39,7 @@ void FreqVisual::paint (juce::Graphics& g)
 
     g.setColour (juce::Colours::white);
     g.setFont (14.0f);
-    g.drawText (juce::String(audioProcessor.frequency), getLocalBounds(),
+    g.drawText (juce::String(audioProcessor.pitchAnalyser.getEstimate().frequency), getLocalBounds(),
                 juce::Justification::centred, true);   // draw some placeholder text
 }
 
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.cpp
+    Created: 18 Oct 2026 5:12:40pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "BiquadCascade.h"
+
+BiquadCascade::BiquadCascade()
+{
+    prepare(0, 1);
+}
+
+void BiquadCascade::prepare(int newNumStages, int newNumChannels)
+{
+    jassert(newNumStages <= maxStages && newNumChannels <= maxChannels);
+
+    numStages = juce::jlimit(0, maxStages, newNumStages);
+    numChannels = juce::jlimit(1, maxChannels, newNumChannels);
+    numActiveStages = numStages;
+
+    // Lanes past the prepared ones pad out the last register, so they have
+    // to pass through too
+    std::fill(std::begin(b0), std::end(b0), 1.0f);
+    for (auto* coefficients : { b1, b2, a1, a2 })
+        std::fill(coefficients, coefficients + maxLanes, 0.0f);
+
+    reset();
+}
+
+void BiquadCascade::reset()
+{
+    std::fill(std::begin(s1), std::end(s1), 0.0f);
+    std::fill(std::begin(s2), std::end(s2), 0.0f);
+    std::fill(std::begin(x), std::end(x), 0.0f);
+    std::fill(std::begin(y), std::end(y), 0.0f);
+}
+
+void BiquadCascade::setNumActiveStages(int newNumActiveStages)
+{
+    newNumActiveStages = juce::jlimit(0, numStages, newNumActiveStages);
+
+    for (int lane = numActiveStages * numChannels; lane < newNumActiveStages * numChannels; ++lane)
+        s1[lane] = s2[lane] = 0.0f;
+
+    numActiveStages = newNumActiveStages;
+}
+
+void BiquadCascade::setStage(int stage, const std::array<float, 6>& coefficients)
+{
+    jassert(stage >= 0 && stage < maxStages);
+
+    const float a0 = coefficients[3];
+    jassert(a0 != 0.0f);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const int lane = stage * numChannels + channel;
+        b0[lane] = coefficients[0] / a0;
+        b1[lane] = coefficients[1] / a0;
+        b2[lane] = coefficients[2] / a0;
+        a1[lane] = coefficients[4] / a0;
+        a2[lane] = coefficients[5] / a0;
+    }
+}
+
+void BiquadCascade::setIdentity(int stage)
+{
+    setStage(stage, { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f });
+}
+
+void BiquadCascade::processLanesScalar(int first, int last) noexcept
+{
+    for (int lane = first; lane < last; ++lane)
+    {
+        const float in = x[lane];
+        const float out = b0[lane] * in + s1[lane];
+        s1[lane] = b1[lane] * in - a1[lane] * out + s2[lane];
+        s2[lane] = b2[lane] * in - a2[lane] * out;
+        y[lane] = out;
+    }
+}
+
+void BiquadCascade::processLanesVectorised(int numLanes) noexcept
+{
+    for (int lane = 0; lane < numLanes; lane += simdWidth)
+    {
+        const auto in = SIMDFloat::fromRawArray(x + lane);
+        const auto out = SIMDFloat::fromRawArray(b0 + lane) * in + SIMDFloat::fromRawArray(s1 + lane);
+
+        const auto state1 = SIMDFloat::fromRawArray(b1 + lane) * in - SIMDFloat::fromRawArray(a1 + lane) * out
+                          + SIMDFloat::fromRawArray(s2 + lane);
+        const auto state2 = SIMDFloat::fromRawArray(b2 + lane) * in - SIMDFloat::fromRawArray(a2 + lane) * out;
+
+        state1.copyToRawArray(s1 + lane);
+        state2.copyToRawArray(s2 + lane);
+        out.copyToRawArray(y + lane);
+    }
+}
+
+void BiquadCascade::process(juce::dsp::AudioBlock<float>& block)
+{
+    const int numSamples = static_cast<int> (block.getNumSamples());
+    const int numBlockChannels = juce::jmin(numChannels, static_cast<int> (block.getNumChannels()));
+    const int stages = numActiveStages;
+    if (stages == 0 || numSamples == 0)
+        return;
+
+    float* channels[maxChannels] = {};
+    for (int channel = 0; channel < numBlockChannels; ++channel)
+        channels[channel] = block.getChannelPointer(static_cast<size_t> (channel));
+
+    const int lastStageLane = (stages - 1) * numChannels;
+    const int numLanes = stages * numChannels;
+    const int numPaddedLanes = (numLanes + simdWidth - 1) / simdWidth * simdWidth;
+
+    // Sample t enters the first stage at step t and leaves the last at step
+    // t + stages - 1. Each sample is read before its slot is written back, so
+    // filtering in place is safe.
+    for (int step = 0; step < numSamples + stages - 1; ++step)
+    {
+        if (step < numSamples)
+            for (int channel = 0; channel < numChannels; ++channel)
+                x[channel] = channel < numBlockChannels ? channels[channel][step] : 0.0f;
+
+        // Stages with a sample to filter at this step
+        const int firstStage = juce::jmax(0, step - numSamples + 1);
+        const int lastStage = juce::jmin(stages - 1, step);
+
+        if (firstStage == 0 && lastStage == stages - 1)
+            processLanesVectorised(numPaddedLanes);
+        else
+            processLanesScalar(firstStage * numChannels, (lastStage + 1) * numChannels);
+
+        if (lastStage == stages - 1)
+            for (int channel = 0; channel < numBlockChannels; ++channel)
+                channels[channel][step - stages + 1] = y[lastStageLane + channel];
+
+        // Each stage's output is the next one's input at the next step
+        const int firstLane = firstStage * numChannels;
+        const int endLane = juce::jmin(lastStage + 1, stages - 1) * numChannels;
+        if (endLane > firstLane)
+            std::copy(y + firstLane, y + endLane, x + firstLane + numChannels);
+    }
+
+    for (int lane = 0; lane < numPaddedLanes; ++lane)
+    {
+        JUCE_SNAP_TO_ZERO(s1[lane]);
+        JUCE_SNAP_TO_ZERO(s2[lane]);
+    }
+}
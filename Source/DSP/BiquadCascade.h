@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.h
+    Created: 18 Oct 2026 5:12:40pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A chain of biquads run on every channel in one pass over the block. The
+// coefficients and states live in structure-of-arrays form with one lane per
+// stage and channel, lane = stage * numChannels + channel.
+//
+// A cascade is serial within a sample, so the lanes run as a skewed
+// wavefront instead: at step t stage k filters sample t - k, which stage
+// k - 1 produced the step before. Once the wavefront has filled, every lane
+// has work at every step and SIMDRegister runs them all together. The block
+// is read and written once whatever the stage count, and is filtered in
+// place.
+class BiquadCascade
+{
+public:
+    static constexpr int maxStages = 16;
+    static constexpr int maxChannels = 2;
+
+    BiquadCascade();
+
+    // Sets every stage to pass through and clears the states
+    void prepare(int numStages, int numChannels);
+    void reset();
+    int getNumStages() const { return numStages; }
+
+    // Stages past this pass through and cost nothing; the ones brought back
+    // start from rest
+    void setNumActiveStages(int numStages);
+    int getNumActiveStages() const { return numActiveStages; }
+
+    // In IIR::ArrayCoefficients order: b0, b1, b2, a0, a1, a2
+    void setStage(int stage, const std::array<float, 6>& coefficients);
+    void setIdentity(int stage);
+
+    // Channels past the prepared count are left alone
+    void process(juce::dsp::AudioBlock<float>& block);
+
+private:
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+    static constexpr int simdWidth = static_cast<int> (SIMDFloat::SIMDNumElements);
+    static constexpr int maxLanes = maxStages * maxChannels;
+    static_assert(maxLanes % simdWidth == 0, "lanes must fill whole registers");
+
+    // Transposed direct form II over lanes [first, last)
+    void processLanesScalar(int first, int last) noexcept;
+    // The same over the first numLanes lanes, a register at a time
+    void processLanesVectorised(int numLanes) noexcept;
+
+    int numStages = 0, numChannels = 1, numActiveStages = 0;
+
+    // Normalised by a0
+    alignas(64) float b0[maxLanes], b1[maxLanes], b2[maxLanes], a1[maxLanes], a2[maxLanes];
+    alignas(64) float s1[maxLanes], s2[maxLanes];
+
+    // Each lane's input and output at the current step
+    alignas(64) float x[maxLanes], y[maxLanes];
+};
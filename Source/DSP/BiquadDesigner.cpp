@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    BiquadDesigner.cpp
+    Created: 18 Oct 2026 7:41:15pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "BiquadDesigner.h"
+
+namespace
+{
+    BiquadDesigner::Coefficients designExactly(BiquadDesigner::Shape shape, double sampleRate,
+                                               float frequency, float quality, float gain)
+    {
+        using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+
+        return shape == BiquadDesigner::notch ? ArrayCoefficients::makeNotch(sampleRate, frequency, quality)
+                                              : ArrayCoefficients::makePeakFilter(sampleRate, frequency, quality, gain);
+    }
+}
+
+void BiquadDesigner::Table::prepare(Shape newShape, double newSampleRate, float newGain,
+                                    float newMinFrequency, float newMaxFrequency, int newPointsPerOctave,
+                                    float newMinQuality, float newMaxQuality, int newNumQualities)
+{
+    jassert(newMinFrequency > 0.0f && newMinFrequency < newMaxFrequency && newMaxFrequency < newSampleRate / 2);
+    jassert(newMinQuality > 0.0f && newMinQuality <= newMaxQuality);
+
+    shape = newShape;
+    sampleRate = newSampleRate;
+    gain = newGain;
+    minFrequency = newMinFrequency;
+    maxFrequency = newMaxFrequency;
+    minQuality = newMinQuality;
+    maxQuality = newMaxQuality;
+
+    // The spacing is stretched a little so the last point lands on the maximum
+    const float octaves = std::log2(maxFrequency / minFrequency);
+    numFrequencies = juce::jmax(2, static_cast<int> (std::ceil(octaves * static_cast<float> (newPointsPerOctave))) + 1);
+    pointsPerOctave = static_cast<float> (numFrequencies - 1) / octaves;
+
+    const float qualityOctaves = std::log2(maxQuality / minQuality);
+    numQualities = qualityOctaves > 0.0f ? juce::jmax(2, newNumQualities) : 1;
+    pointsPerQualityOctave = numQualities > 1 ? static_cast<float> (numQualities - 1) / qualityOctaves : 0.0f;
+
+    grid.resize(static_cast<size_t> (numFrequencies * numQualities));
+    for (int q = 0; q < numQualities; ++q)
+    {
+        const float quality = numQualities > 1 ? minQuality * std::exp2(static_cast<float> (q) / pointsPerQualityOctave) : minQuality;
+
+        for (int f = 0; f < numFrequencies; ++f)
+        {
+            const float frequency = juce::jmin(maxFrequency, minFrequency * std::exp2(static_cast<float> (f) / pointsPerOctave));
+            const auto exact = designExactly(shape, sampleRate, frequency, quality, gain);
+
+            auto& point = grid[static_cast<size_t> (q * numFrequencies + f)];
+            point = { exact[0] / exact[3], exact[1] / exact[3], exact[2] / exact[3], exact[4] / exact[3], exact[5] / exact[3] };
+        }
+    }
+}
+
+bool BiquadDesigner::Table::covers(Shape shapeToDesign, double rate, float frequency, float quality, float gainToDesign) const noexcept
+{
+    return ! grid.empty()
+        && shapeToDesign == shape
+        && rate == sampleRate
+        && (shape == notch || gainToDesign == gain)
+        && frequency >= minFrequency && frequency <= maxFrequency
+        && quality >= minQuality && quality <= maxQuality;
+}
+
+void BiquadDesigner::Table::lookup(float frequency, float quality, Coefficients& result) const noexcept
+{
+    const auto locate = [](float position, int numPoints, int& index, float& fraction)
+    {
+        index = juce::jlimit(0, juce::jmax(0, numPoints - 2), static_cast<int> (position));
+        fraction = juce::jlimit(0.0f, 1.0f, position - static_cast<float> (index));
+    };
+
+    int f = 0, q = 0;
+    float fFraction = 0.0f, qFraction = 0.0f;
+    locate(std::log2(frequency / minFrequency) * pointsPerOctave, numFrequencies, f, fFraction);
+    if (numQualities > 1)
+        locate(std::log2(quality / minQuality) * pointsPerQualityOctave, numQualities, q, qFraction);
+
+    const auto* row = grid.data() + q * numFrequencies + f;
+    const auto* nextRow = numQualities > 1 ? row + numFrequencies : row;
+
+    std::array<float, 5> blended;
+    for (size_t i = 0; i < blended.size(); ++i)
+    {
+        const float low = row[0][i] + fFraction * (row[1][i] - row[0][i]);
+        const float high = nextRow[0][i] + fFraction * (nextRow[1][i] - nextRow[0][i]);
+        blended[i] = low + qFraction * (high - low);
+    }
+
+    result = { blended[0], blended[1], blended[2], 1.0f, blended[3], blended[4] };
+}
+
+BiquadDesigner::BiquadDesigner()
+{
+    coefficients = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+}
+
+void BiquadDesigner::setTable(const Table* tableToUse)
+{
+    table = tableToUse;
+    invalidate();
+}
+
+void BiquadDesigner::invalidate() noexcept
+{
+    // No real sample rate is zero
+    lastSampleRate = 0.0;
+}
+
+bool BiquadDesigner::designNotch(double sampleRate, float frequency, float quality) noexcept
+{
+    return design(notch, sampleRate, frequency, quality, 1.0f);
+}
+
+bool BiquadDesigner::designPeak(double sampleRate, float frequency, float quality, float gain) noexcept
+{
+    return design(peak, sampleRate, frequency, quality, gain);
+}
+
+bool BiquadDesigner::design(Shape shape, double sampleRate, float frequency, float quality, float gain) noexcept
+{
+    if (shape == lastShape && sampleRate == lastSampleRate && frequency == lastFrequency
+        && quality == lastQuality && gain == lastGain)
+        return false;
+
+    lastShape = shape;
+    lastSampleRate = sampleRate;
+    lastFrequency = frequency;
+    lastQuality = quality;
+    lastGain = gain;
+
+    if (table != nullptr && table->covers(shape, sampleRate, frequency, quality, gain))
+        table->lookup(frequency, quality, coefficients);
+    else
+        coefficients = designExactly(shape, sampleRate, frequency, quality, gain);
+
+    return true;
+}
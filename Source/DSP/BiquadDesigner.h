@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    BiquadDesigner.h
+    Created: 18 Oct 2026 7:41:15pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Designs notch and peak biquads on the audio thread. It never allocates,
+// and it only redesigns when the sample rate, frequency, Q or gain has
+// changed since the last call, so a filter can ask for its coefficients
+// every block and pay only when it is retuned.
+//
+// Pitch-tracked filters are retuned every block, and there the sin, cos and
+// tan of an exact design add up over many stages. A Table trades them for
+// a bilinear lookup over a log-spaced grid of frequency and Q.
+class BiquadDesigner
+{
+public:
+    enum Shape
+    {
+        notch,
+        peak
+    };
+
+    // In IIR::ArrayCoefficients order: b0, b1, b2, a0, a1, a2
+    using Coefficients = std::array<float, 6>;
+
+    // Coefficients of one shape at one sample rate and gain, over a grid
+    // evenly spaced in log-frequency and log-Q. Neighbouring grid points are
+    // interpolated coefficient by coefficient: the stable (a1, a2) form a
+    // triangle, so a blend of stable filters is stable too.
+    class Table
+    {
+    public:
+        // Allocates, so it belongs in prepare. One quality gives a table
+        // for that Q only.
+        void prepare(Shape shape, double sampleRate, float gain,
+                     float minFrequency, float maxFrequency, int pointsPerOctave,
+                     float minQuality, float maxQuality, int numQualities);
+
+        // Whether lookup can stand in for an exact design of these
+        bool covers(Shape shape, double sampleRate, float frequency, float quality, float gain) const noexcept;
+
+        void lookup(float frequency, float quality, Coefficients& result) const noexcept;
+
+    private:
+        Shape shape = notch;
+        double sampleRate = 0.0;
+        float gain = 1.0f;
+        float minFrequency = 0.0f, maxFrequency = 0.0f;
+        float minQuality = 0.0f, maxQuality = 0.0f;
+        float pointsPerOctave = 1.0f, pointsPerQualityOctave = 0.0f;
+        int numFrequencies = 0, numQualities = 0;
+
+        // Normalised b0, b1, b2, a1, a2; quality-major
+        std::vector<std::array<float, 5>> grid;
+    };
+
+    BiquadDesigner();
+
+    // Designs from the table where it covers the settings, and exactly
+    // otherwise. The table has to outlive the designer.
+    void setTable(const Table* tableToUse);
+
+    // Makes the next design run whatever its settings
+    void invalidate() noexcept;
+
+    // True when the coefficients changed
+    bool designNotch(double sampleRate, float frequency, float quality) noexcept;
+    bool designPeak(double sampleRate, float frequency, float quality, float gain) noexcept;
+
+    const Coefficients& getCoefficients() const noexcept { return coefficients; }
+
+private:
+    bool design(Shape shape, double sampleRate, float frequency, float quality, float gain) noexcept;
+
+    const Table* table = nullptr;
+
+    Shape lastShape = notch;
+    double lastSampleRate = 0.0;
+    float lastFrequency = 0.0f, lastQuality = 0.0f, lastGain = 0.0f;
+
+    Coefficients coefficients;
+};
@@ -10,116 +10,469 @@
 
 #include "Convolution.h"
 
-Convolution::Convolution() 
+Convolution::Convolution()
+    : loader([this] { idle(); })
 {
-    originalIRBuffer.clear();
-    modifiedIRBuffer.clear();
+    formatManager.registerBasicFormats();
+}
+
+Convolution::~Convolution()
+{
+    loader.stop();
+    delete pendingEngine.exchange(nullptr);
+    delete retiredEngine.exchange(nullptr);
+}
+
+void Convolution::setQualityProfile(const QualityProfile& newProfile)
+{
+    quality = newProfile;
 }
 
 void Convolution::prepare(juce::dsp::ProcessSpec& spec)
 {
-    sampleRate = spec.sampleRate;
+    // Never waits on a build: the loader only takes irLock to compare the
+    // spec and publish, and rebuilds if this changed it meanwhile
+    const juce::ScopedLock lock(irLock);
+
+    engineSpec.sampleRate = spec.sampleRate;
+    engineSpec.maxBlockSize = static_cast<int> (spec.maximumBlockSize);
+    engineSpec.numChannels = static_cast<int> (spec.numChannels);
+    engineSpec.quality = quality;
+
+    if (engineSpec.quality.deferConvolutionTail && tailWorker == nullptr)
+        tailWorker = std::make_unique<TailWorker>();
+
+    // The audio thread is stopped, so the engines can be replaced directly
+    delete pendingEngine.exchange(nullptr);
+    delete retiredEngine.exchange(nullptr);
+    fadingEngine.reset();
+    isCrossfading = false;
 
-    convolver.prepare(spec);
-    convolver.reset();
-    dryWetMixer.prepare(spec);
-    dryWetMixer.reset();
+    // A spec the IR has been built for before comes straight back from the
+    // cache; anything else is built by the loader thread and faded in
+    engine.reset();
+    if (auto partitions = IRCache::find(publishedKey, engineSpec))
+    {
+        engine = std::make_unique<PartitionedConvolver>(partitions, engineSpec.maxBlockSize, engineSpec.numChannels, getTailWorker(engineSpec));
+        publishedSpec = engineSpec;
+    }
+    activeIRLength = engine != nullptr ? engine->getIRLength() : 0;
+    tailLengthSeconds = activeIRLength / engineSpec.sampleRate;
+
+    crossfade.reset(spec.sampleRate, crossfadeSeconds);
+    mix.reset(spec.sampleRate, ParameterSmoothing::rampLengthSeconds);
+    dryBuffer.setSize(static_cast<int> (spec.numChannels), static_cast<int> (spec.maximumBlockSize));
+    fadeBuffer.setSize(static_cast<int> (spec.numChannels), static_cast<int> (spec.maximumBlockSize));
+    rampBuffer.setSize(4, static_cast<int> (spec.maximumBlockSize));
+
+    const int maxPreDelaySamples = juce::roundToInt(IREdits::maxPreDelaySeconds * spec.sampleRate);
+    preDelayLine.setSize(static_cast<int> (spec.numChannels), maxPreDelaySamples + static_cast<int> (spec.maximumBlockSize));
+    preDelayLine.clear();
+    preDelayScratch.setSize(1, static_cast<int> (spec.maximumBlockSize));
+    preDelayWritePosition = 0;
+    preDelaySamples = previousPreDelaySamples = getTargetPreDelaySamples();
+    preDelayFade.reset(spec.sampleRate, preDelayFadeSeconds);
+    preDelayFade.setCurrentAndTargetValue(1.0f);
+    isPreDelayLineSilent = true;
 }
 
-void Convolution::process(juce::dsp::AudioBlock<float>& block)
+void Convolution::setMix(float newMix)
 {
-    dryWetMixer.setWetMixProportion(mix / 100.0f);
-    dryWetMixer.pushDrySamples(block);
-    convolver.process(juce::dsp::ProcessContextReplacing<float>(block));
-    dryWetMixer.mixWetSamples(block);
+    mix.setTargetValue(newMix / 100.0f);
 }
 
-void Convolution::setIRBufferSize(int newNumChannels, int newNumSamples, bool keepExistingContent, bool clearExtraSpace, bool avoidReallocating)
+void Convolution::process(juce::dsp::AudioBlock<float>& block, juce::int64 silentInputSamples)
 {
-    originalIRBuffer.setSize(newNumChannels, newNumSamples, keepExistingContent, clearExtraSpace, avoidReallocating);
+    const auto numBlockChannels = juce::jmin(static_cast<int> (block.getNumChannels()), dryBuffer.getNumChannels());
+    const auto numSamples = static_cast<int> (block.getNumSamples());
+
+    takePendingEngine();
+
+    // The engine is linear and every input it still holds is silent, so its
+    // output would be too; picking up again later is seamless for the same
+    // reason
+    if (canSleep(silentInputSamples - numSamples))
+    {
+        mix.skip(numSamples);
+        block.multiplyBy(1.0f - mix.getCurrentValue());
+
+        // The pre-delay line isn't written while asleep, so whatever it holds
+        // would come back out of order; it is all silence anyway
+        if (! isPreDelayLineSilent)
+        {
+            preDelayLine.clear();
+            isPreDelayLineSilent = true;
+        }
+        return;
+    }
+
+    for (int channel = 0; channel < numBlockChannels; ++channel)
+        dryBuffer.copyFrom(channel, 0, block.getChannelPointer(static_cast<size_t> (channel)), numSamples);
+
+    applyPreDelay(block);
+
+    if (isCrossfading)
+    {
+        for (int channel = 0; channel < numBlockChannels; ++channel)
+            fadeBuffer.copyFrom(channel, 0, block.getChannelPointer(static_cast<size_t> (channel)), numSamples);
+
+        if (fadingEngine != nullptr)
+        {
+            juce::dsp::AudioBlock<float> fadeBlock(fadeBuffer.getArrayOfWritePointers(), static_cast<size_t> (numBlockChannels), static_cast<size_t> (numSamples));
+            fadingEngine->process(fadeBlock);
+        }
+    }
+
+    if (engine != nullptr)
+        engine->process(block);
+
+    if (isCrossfading)
+        applyCrossfade(block);
+
+    // Linear dry/wet, the same rule DryWetMixer used
+    float* wetRamp = rampBuffer.getWritePointer(0);
+    float* dryRamp = rampBuffer.getWritePointer(1);
+    float wetGain = 0.0f, dryGain = 0.0f;
+    const bool isSmoothing = ParameterSmoothing::fillMixRamps(mix, wetRamp, dryRamp, numSamples, wetGain, dryGain);
+
+    for (int channel = 0; channel < numBlockChannels; ++channel)
+    {
+        float* data = block.getChannelPointer(static_cast<size_t> (channel));
+        const float* dry = dryBuffer.getReadPointer(channel);
+
+        if (isSmoothing)
+        {
+            juce::FloatVectorOperations::multiply(data, wetRamp, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(data, dry, dryRamp, numSamples);
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply(data, wetGain, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(data, dry, dryGain, numSamples);
+        }
+    }
 }
 
-juce::AudioBuffer<float>& Convolution::getOriginalIR()
+void Convolution::takePendingEngine()
 {
-    return originalIRBuffer;
+    // Wait until the last fade is over and its engine has been collected,
+    // so there is always somewhere to put the engine being replaced
+    if (isCrossfading || retiredEngine.load() != nullptr)
+        return;
+
+    if (auto* next = pendingEngine.exchange(nullptr))
+    {
+        fadingEngine = std::move(engine);
+        engine.reset(next);
+
+        crossfade.setCurrentAndTargetValue(0.0f);
+        crossfade.setTargetValue(1.0f);
+        isCrossfading = true;
+    }
 }
 
-juce::AudioBuffer<float>& Convolution::getModifiedIR()
+bool Convolution::canSleep(juce::int64 silenceBeforeBlock) const
 {
-    return modifiedIRBuffer;
+    // Output sample n hears inputs n - preDelay - irLength + 1 .. n - preDelay
+    return engine != nullptr && ! isCrossfading && ! preDelayFade.isSmoothing()
+        && silenceBeforeBlock >= engine->getIRLength() + preDelaySamples;
 }
 
-void Convolution::loadImpulseResponse()
+int Convolution::getTargetPreDelaySamples() const
 {
-    // Nomalize IR signal
-    float globalMaxMagnitude = originalIRBuffer.getMagnitude(0, originalIRBuffer.getNumSamples());
-    originalIRBuffer.applyGain(1.0f / (globalMaxMagnitude + 0.01));
+    return juce::roundToInt(juce::jlimit(0.0f, IREdits::maxPreDelaySeconds, editPreDelay.load()) * engineSpec.sampleRate);
+}
 
-    // Trim the white space before and after the signal
-    int numSamples = originalIRBuffer.getNumSamples();
-    int blockSize = static_cast<int>(std::floor(sampleRate) / 100);
-    int startBlockNum = 0;
-    int endBlockNum = numSamples / blockSize;
+void Convolution::applyPreDelay(juce::dsp::AudioBlock<float>& block)
+{
+    const auto numBlockChannels = juce::jmin(static_cast<int> (block.getNumChannels()), preDelayLine.getNumChannels());
+    const auto numSamples = static_cast<int> (block.getNumSamples());
+    const int lineLength = preDelayLine.getNumSamples();
+    jassert(numSamples <= preDelayScratch.getNumSamples());
 
-    // Find the first sample in the IR signal that is greater than 0.001
-    float localMaxMagnitude = 0.0f;
-    while ((startBlockNum + 1) * blockSize < numSamples)
+    if (! preDelayFade.isSmoothing())
     {
-        localMaxMagnitude = originalIRBuffer.getMagnitude(startBlockNum * blockSize, blockSize);
-        if (localMaxMagnitude > 0.001)
+        const int target = getTargetPreDelaySamples();
+        if (target != preDelaySamples)
         {
-            break;
+            previousPreDelaySamples = preDelaySamples;
+            preDelaySamples = target;
+            preDelayFade.setCurrentAndTargetValue(0.0f);
+            preDelayFade.setTargetValue(1.0f);
         }
-        ++startBlockNum;
     }
 
-    // Find the last sample in the IR signal that is greater than 0.001
-    localMaxMagnitude = 0.0f;
-    while ((endBlockNum - 1) * blockSize > 0)
+    // The block goes in first, so a delay shorter than the block reads part
+    // of it straight back
+    const int firstPart = juce::jmin(numSamples, lineLength - preDelayWritePosition);
+    for (int channel = 0; channel < numBlockChannels; ++channel)
+    {
+        const float* input = block.getChannelPointer(static_cast<size_t> (channel));
+        preDelayLine.copyFrom(channel, preDelayWritePosition, input, firstPart);
+        preDelayLine.copyFrom(channel, 0, input + firstPart, numSamples - firstPart);
+    }
+    isPreDelayLineSilent = false;
+
+    float* ramp = rampBuffer.getWritePointer(3);
+    const bool isFading = ParameterSmoothing::fillRamp(preDelayFade, ramp, numSamples);
+
+    if (preDelaySamples > 0 || isFading)
     {
-        --endBlockNum;
-        localMaxMagnitude = originalIRBuffer.getMagnitude(endBlockNum * blockSize, blockSize);
-        if (localMaxMagnitude > 0.001)
+        for (int channel = 0; channel < numBlockChannels; ++channel)
         {
-            break;
+            float* data = block.getChannelPointer(static_cast<size_t> (channel));
+            readPreDelay(channel, preDelaySamples, data, numSamples);
+
+            if (isFading)
+            {
+                // new * ramp + old * (1 - ramp), as in applyCrossfade
+                float* old = preDelayScratch.getWritePointer(0);
+                readPreDelay(channel, previousPreDelaySamples, old, numSamples);
+
+                juce::FloatVectorOperations::subtract(data, old, numSamples);
+                juce::FloatVectorOperations::multiply(data, ramp, numSamples);
+                juce::FloatVectorOperations::add(data, old, numSamples);
+            }
         }
     }
 
-    // Calculate the length of the cropped IR signal
-    int trimmedNumSamples;
-    // If the tail has been clipped
-    if (endBlockNum * blockSize < numSamples)
+    preDelayWritePosition = (preDelayWritePosition + numSamples) % lineLength;
+}
+
+void Convolution::readPreDelay(int channel, int delay, float* destination, int numSamples) const
+{
+    const int lineLength = preDelayLine.getNumSamples();
+    const int start = (preDelayWritePosition - delay + lineLength) % lineLength;
+    const int firstPart = juce::jmin(numSamples, lineLength - start);
+
+    juce::FloatVectorOperations::copy(destination, preDelayLine.getReadPointer(channel, start), firstPart);
+    juce::FloatVectorOperations::copy(destination + firstPart, preDelayLine.getReadPointer(channel), numSamples - firstPart);
+}
+
+void Convolution::applyCrossfade(juce::dsp::AudioBlock<float>& block)
+{
+    const auto numBlockChannels = juce::jmin(static_cast<int> (block.getNumChannels()), fadeBuffer.getNumChannels());
+    const auto numSamples = static_cast<int> (block.getNumSamples());
+
+    float* ramp = rampBuffer.getWritePointer(2);
+    if (! ParameterSmoothing::fillRamp(crossfade, ramp, numSamples))
+        juce::FloatVectorOperations::fill(ramp, 1.0f, numSamples);
+
+    // new * ramp + old * (1 - ramp) = old + (new - old) * ramp
+    for (int channel = 0; channel < numBlockChannels; ++channel)
+    {
+        float* data = block.getChannelPointer(static_cast<size_t> (channel));
+        const float* old = fadeBuffer.getReadPointer(channel);
+
+        juce::FloatVectorOperations::subtract(data, old, numSamples);
+        juce::FloatVectorOperations::multiply(data, ramp, numSamples);
+        juce::FloatVectorOperations::add(data, old, numSamples);
+    }
+
+    if (! crossfade.isSmoothing())
     {
-        trimmedNumSamples = (endBlockNum - startBlockNum) * blockSize - 1;
+        isCrossfading = false;
+        retiredEngine.store(fadingEngine.release());
     }
-    else
+}
+
+void Convolution::loadImpulseResponse(const juce::File& file)
+{
+    loader.post([this, file] { loadFile(file); });
+}
+
+void Convolution::setEdits(const IREdits& edits)
+{
+    editReverse = edits.reverse;
+    editDecay = edits.decay;
+    editPreDelay = edits.preDelaySeconds;
+}
+
+IREdits Convolution::getEdits() const
+{
+    IREdits edits;
+    edits.reverse = editReverse;
+    edits.decay = editDecay;
+    edits.preDelaySeconds = editPreDelay;
+    return edits;
+}
+
+void Convolution::loadFile(const juce::File& file)
+{
+    const auto contentHash = IRCache::hashFile(file);
+    const auto edits = getEdits();
+    const auto spec = getEngineSpec();
+
+    // A hit brings the trimmed IR along, so the file is only decoded on a
+    // miss, and nothing is rendered until an edit needs it
+    Build built;
+    juce::AudioBuffer<float> source;
+    double sourceSampleRate = 0.0;
+    built.partitions = IRCache::find(getCacheKey(contentHash, edits), spec, &source, &sourceSampleRate, &built.waveform);
+
+    if (built.partitions == nullptr && ! IRProcessing::readFile(formatManager, file, source, sourceSampleRate))
+        return;
+
+    pipeline.setSource(std::move(source), sourceSampleRate);
+    sourceHash = contentHash;
+    renderedEdits = edits;
+
+    if (built.partitions == nullptr)
+        built = build(spec, edits, true);
+
     {
-        trimmedNumSamples = numSamples - startBlockNum * blockSize;
+        const juce::ScopedLock lock(irLock);
+        impulseResponseFile = file;
     }
 
-    // Redefine the buffer size of IR
-    modifiedIRBuffer.setSize(originalIRBuffer.getNumChannels(), trimmedNumSamples, false, true, false);
-    // Move samples
-    for (int channel = 0; channel < originalIRBuffer.getNumChannels(); ++channel)
+    publish(spec, std::move(built));
+}
+
+void Convolution::idle()
+{
+    delete retiredEngine.exchange(nullptr);
+
+    const auto edits = getEdits();
+    bool isSpecBuilt = false;
+    const auto spec = getEngineSpec(&isSpecBuilt);
+
+    // The pre-delay is applied on the audio thread, so only reverse and
+    // decay ever need a rebuild
+    const bool isSettled = edits.rendersLike(lastPolledEdits);
+    lastPolledEdits = edits;
+    if (! pipeline.hasSource() || (isSpecBuilt && edits.rendersLike(renderedEdits)))
+        return;
+
+    // Every rebuild re-partitions the whole IR, so while a control is still
+    // moving they are spaced out; the setting it comes to rest on is always
+    // built
+    const auto now = juce::Time::getMillisecondCounter();
+    if (isSpecBuilt && ! isSettled && now - lastRebuildMs < minRebuildIntervalMs)
+        return;
+    lastRebuildMs = now;
+
+    // Sweeping a control passes through many settings, so only settled ones
+    // are written to the cache
+    renderedEdits = edits;
+    publish(spec, build(spec, edits, isSettled || ! isSpecBuilt));
+}
+
+Convolution::Build Convolution::build(const EngineSpec& spec, const IREdits& edits, bool storeInCache)
+{
+    const auto key = getCacheKey(edits);
+
+    Build built;
+    built.partitions = IRCache::find(key, spec, nullptr, nullptr, &built.waveform);
+    if (built.partitions != nullptr)
+        return built;
+
+    const auto& rendered = pipeline.render(spec.sampleRate, edits);
+    built.partitions = IRProcessing::partition(rendered, spec);
+    built.waveform = summariseWaveform(rendered);
+
+    if (storeInCache)
+        IRCache::store(key, spec, pipeline.getSource(), pipeline.getSourceSampleRate(), built.waveform, *built.partitions);
+
+    return built;
+}
+
+void Convolution::publish(EngineSpec spec, Build built)
+{
+    for (;;)
     {
-        for (int sample = 0; sample < trimmedNumSamples; ++sample)
+        auto newEngine = std::make_unique<PartitionedConvolver>(built.partitions, spec.maxBlockSize, spec.numChannels, getTailWorker(spec));
+
         {
-            modifiedIRBuffer.setSample(channel, sample, originalIRBuffer.getSample(channel, sample + startBlockNum * blockSize));
+            const juce::ScopedLock lock(irLock);
+            if (spec == engineSpec)
+            {
+                waveform = std::move(built.waveform);
+                publishedKey = getCacheKey(renderedEdits);
+                publishedSpec = spec;
+                activeIRLength = newEngine->getIRLength();
+                tailLengthSeconds = activeIRLength / engineSpec.sampleRate;
+
+                // An engine still pending was never seen by the audio thread
+                delete pendingEngine.exchange(newEngine.release());
+                break;
+            }
+
+            // A prepare came in while this was being built
+            spec = engineSpec;
         }
+
+        built = build(spec, renderedEdits, true);
+    }
+
+    sendChangeMessage();
+}
+
+EngineSpec Convolution::getEngineSpec(bool* isBuilt) const
+{
+    const juce::ScopedLock lock(irLock);
+
+    if (isBuilt != nullptr)
+        *isBuilt = publishedSpec == engineSpec;
+
+    return engineSpec;
+}
+
+TailWorker* Convolution::getTailWorker(const EngineSpec& spec) const
+{
+    // Made by the prepare that set a deferring spec, before anyone could
+    // have read that spec
+    return spec.quality.deferConvolutionTail ? tailWorker.get() : nullptr;
+}
+
+std::vector<float> Convolution::summariseWaveform(const juce::AudioBuffer<float>& rendered)
+{
+    const int numSamples = rendered.getNumSamples();
+    const int numSlices = juce::jmin(numSamples, waveformResolution);
+    std::vector<float> slices(static_cast<size_t> (numSlices), 0.0f);
+
+    for (int slice = 0; slice < numSlices; ++slice)
+    {
+        const int start = static_cast<int> (static_cast<juce::int64> (slice) * numSamples / numSlices);
+        const int end = static_cast<int> (static_cast<juce::int64> (slice + 1) * numSamples / numSlices);
+        slices[static_cast<size_t> (slice)] = rendered.getMagnitude(0, start, end - start);
     }
 
-    // Copy back to originalIRBuffer
-    originalIRBuffer.makeCopyOf(modifiedIRBuffer);
+    return slices;
+}
+
+uint64_t Convolution::getCacheKey(const IREdits& edits) const
+{
+    return getCacheKey(sourceHash, edits);
+}
+
+uint64_t Convolution::getCacheKey(uint64_t contentHash, const IREdits& edits)
+{
+    if (contentHash == 0)
+        return 0;
+
+    // Only what changes the rendered IR; see IREdits::rendersLike
+    const float fields[] = { edits.reverse ? 1.0f : 0.0f, edits.decay };
+    return IRCache::combine(contentHash, fields, sizeof(fields));
+}
 
-    updateImpulseResponse(modifiedIRBuffer);
+std::vector<float> Convolution::getWaveform() const
+{
+    const juce::ScopedLock lock(irLock);
+    return waveform;
 }
 
-void Convolution::updateImpulseResponse(juce::AudioBuffer<float> irBuffer)
+juce::File Convolution::getImpulseResponseFile() const
 {
-    convolver.loadImpulseResponse(std::move(irBuffer), sampleRate, juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::yes);
+    const juce::ScopedLock lock(irLock);
+    return impulseResponseFile;
 }
 
 int Convolution::getCurrentIRSize()
 {
-    return convolver.getCurrentIRSize();
-}
\ No newline at end of file
+    return activeIRLength;
+}
+
+double Convolution::getTailLengthSeconds() const
+{
+    return tailLengthSeconds + juce::jlimit(0.0f, IREdits::maxPreDelaySeconds, editPreDelay.load());
+}
@@ -10,30 +10,155 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "../Utils/Parameters.h"
+#include "../Utils/QualityProfile.h"
+#include "PartitionedConvolver.h"
+#include "IRLoader.h"
+#include "IRCache.h"
+#include "IRPipeline.h"
 
-class Convolution
+// Sends a change message whenever a new or re-edited IR is on its way in
+class Convolution : public juce::ChangeBroadcaster
 {
 public:
 	Convolution();
+    ~Convolution() override;
+
+    // Takes effect on the next prepare, reloading the current IR if needed
+    void setQualityProfile(const QualityProfile& newProfile);
 
     void prepare(juce::dsp::ProcessSpec& spec);
-    void process(juce::dsp::AudioBlock<float>& block);
 
-    void setIRBufferSize(int newNumChannels, int newNumSamples, bool keepExistingContent = false, bool clearExtraSpace = false, bool avoidReallocating = false);
-    juce::AudioBuffer<float>& getOriginalIR();
-    juce::AudioBuffer<float>& getModifiedIR();
-    void loadImpulseResponse();
-    void updateImpulseResponse(juce::AudioBuffer<float> irBuffer);
+    // silentInputSamples is how long the block's source has been silent (see
+    // SilenceDetector). Once the silence before the block covers the IR, the
+    // tail has played out and the engine is skipped until sound comes back;
+    // only the dry gain is applied.
+    void process(juce::dsp::AudioBlock<float>& block, juce::int64 silentInputSamples);
+
+    // Decodes, trims and partitions the file on the loader thread (or reads
+    // it from the IR cache), then crossfades to it; safe to call while audio
+    // is running
+    void loadImpulseResponse(const juce::File& file);
+
+    // Wait-free, so it can be called every block. The pre-delay is a delay
+    // on the engine's input and follows at once, faded over a few
+    // milliseconds. For reverse and decay the loader thread re-renders the
+    // edit pipeline from the first stage that changed and crossfades to it;
+    // while they are being swept it does so at most every
+    // minRebuildIntervalMs.
+    void setEdits(const IREdits& edits);
+
+    // Peak magnitude of the first IR channel over each of up to
+    // waveformResolution equal slices, reverse and decay included; for
+    // display
+    std::vector<float> getWaveform() const;
+    juce::File getImpulseResponseFile() const;
 
     int getCurrentIRSize();
+    double getTailLengthSeconds() const;
+
+    // Wet proportion in percent, smoothed
+    void setMix(float newMix);
 
-    float mix{ 0 };
+    static constexpr int waveformResolution = 1024;
 
 private:
-    int sampleRate = 48000;
+    // What a build hands to publish
+    struct Build
+    {
+        std::shared_ptr<const PartitionedIR> partitions;
+        std::vector<float> waveform;
+    };
+
+    // Loader thread. Builds run without a lock, from a snapshot of the spec
+    // and the edits; publish takes irLock only to check the spec is still
+    // current and hand the engine over, and builds again if it isn't.
+    void loadFile(const juce::File& file);
+    void idle();
+    Build build(const EngineSpec& spec, const IREdits& edits, bool storeInCache);
+    void publish(EngineSpec spec, Build built);
+    uint64_t getCacheKey(const IREdits& edits) const;
+    static uint64_t getCacheKey(uint64_t contentHash, const IREdits& edits);
+
+    // The current spec, and whether the published engine was built for it
+    EngineSpec getEngineSpec(bool* isBuilt = nullptr) const;
+    // Null unless the spec defers the tail
+    TailWorker* getTailWorker(const EngineSpec& spec) const;
+    static std::vector<float> summariseWaveform(const juce::AudioBuffer<float>& rendered);
+
+    IREdits getEdits() const;
+
+    // Audio thread
+    void takePendingEngine();
+    bool canSleep(juce::int64 silenceBeforeBlock) const;
+    void applyCrossfade(juce::dsp::AudioBlock<float>& block);
+    int getTargetPreDelaySamples() const;
+    void applyPreDelay(juce::dsp::AudioBlock<float>& block);
+    void readPreDelay(int channel, int delay, float* destination, int numSamples) const;
+
+    QualityProfile quality{ QualityProfile::realtime() };
+    std::atomic<int> activeIRLength{ 0 };
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+
+    // Runs the large partitions of every engine built while the profile asks
+    // for it; declared first so it outlives them. Created by prepare.
+    std::unique_ptr<TailWorker> tailWorker;
+
+    // Engine hand-over, wait-free for the audio thread. The loader publishes
+    // into pendingEngine; the audio thread takes it with an exchange, plays
+    // it alongside the old engine for crossfadeSeconds, then hands the old
+    // one back through retiredEngine for the loader thread to delete. A new
+    // engine is only taken once the last retired one has been collected.
+    std::unique_ptr<PartitionedConvolver> engine;
+    std::unique_ptr<PartitionedConvolver> fadingEngine;
+    std::atomic<PartitionedConvolver*> pendingEngine{ nullptr };
+    std::atomic<PartitionedConvolver*> retiredEngine{ nullptr };
+    juce::SmoothedValue<float> crossfade;
+    bool isCrossfading = false;
+    juce::AudioBuffer<float> fadeBuffer;
+
+    static constexpr double crossfadeSeconds = 0.05;
+
+    // Requested edits, written by setEdits
+    std::atomic<bool> editReverse{ false };
+    std::atomic<float> editDecay{ 1.0f };
+    std::atomic<float> editPreDelay{ 0.0f };
+
+    // Pre-delay line in front of the engines, audio thread only. A new
+    // delay fades in from the old one, and is only picked up once the
+    // last fade has finished.
+    juce::AudioBuffer<float> preDelayLine;
+    juce::AudioBuffer<float> preDelayScratch;
+    int preDelayWritePosition = 0;
+    int preDelaySamples = 0, previousPreDelaySamples = 0;
+    juce::SmoothedValue<float> preDelayFade;
+    bool isPreDelayLineSilent = true;
+
+    static constexpr double preDelayFadeSeconds = 0.01;
+
+    // Loader thread only
+    IRPipeline pipeline;
+    IREdits renderedEdits;
+    uint64_t sourceHash = 0;
+
+    // Spaces out rebuilds while a control is being swept
+    IREdits lastPolledEdits;
+    juce::uint32 lastRebuildMs = 0;
+    static constexpr juce::uint32 minRebuildIntervalMs = 250;
+
+    // Guards the spec and what the message thread reads. Held only briefly,
+    // never across a build.
+    mutable juce::CriticalSection irLock;
+    EngineSpec engineSpec;
+    EngineSpec publishedSpec;       // what the last published engine was built for
+    uint64_t publishedKey = 0;      // and its cache key, for prepare to recall
+    juce::File impulseResponseFile;
+    std::vector<float> waveform;
+
+    ParameterSmoothing::Mix mix;
+    juce::AudioBuffer<float> dryBuffer;
+    juce::AudioBuffer<float> rampBuffer;
 
-    juce::dsp::Convolution convolver;
-    juce::AudioBuffer<float> originalIRBuffer;
-    juce::AudioBuffer<float> modifiedIRBuffer;
-    juce::dsp::DryWetMixer<float> dryWetMixer;
-};
\ No newline at end of file
+    juce::AudioFormatManager formatManager;     // loader thread only
+    IRLoader loader;
+};
@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+    IRCache.cpp
+    Created: 17 Oct 2026 6:21:40pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "IRCache.h"
+
+namespace IRCache
+{
+namespace
+{
+    constexpr uint32_t fileMagic = 0x52494c42;   // "BLIR"
+    constexpr uint32_t formatVersion = 3;
+    constexpr int maxNumStages = 32;
+
+    constexpr uint64_t fnvOffsetBasis = 14695981039346656037ull;
+    constexpr uint64_t fnvPrime = 1099511628211ull;
+
+    uint64_t fnv1a(const void* data, size_t numBytes, uint64_t hash = fnvOffsetBasis)
+    {
+        auto* bytes = static_cast<const uint8_t*> (data);
+        for (size_t i = 0; i < numBytes; ++i)
+            hash = (hash ^ bytes[i]) * fnvPrime;
+
+        return hash;
+    }
+
+    struct Header
+    {
+        uint32_t magic, version;
+        uint64_t key;
+        int32_t irLength, numIRChannels, headLength, numStages;
+        int32_t sourceLength, numSourceChannels;
+        int32_t waveformSize, reserved;
+        double sourceSampleRate;
+    };
+
+    struct StageHeader
+    {
+        int32_t partitionSize, offset, numPartitions, reserved;
+    };
+
+    size_t alignedSize(size_t numBytes)
+    {
+        return (numBytes + 15) & ~static_cast<size_t> (15);
+    }
+
+    uint64_t makeKey(uint64_t contentHash, const EngineSpec& spec)
+    {
+        const int64_t fields[] = { formatVersion,
+                                   std::llround(spec.sampleRate * 1000.0),
+                                   spec.maxBlockSize,
+                                   spec.numChannels,
+                                   std::llround(spec.quality.maxIRLengthSeconds * 1000.0),
+                                   spec.quality.deferConvolutionTail ? 1 : 0 };
+
+        return fnv1a(fields, sizeof(fields), contentHash);
+    }
+
+    juce::File getEntryFile(uint64_t key)
+    {
+        return getDirectory().getChildFile(juce::String::toHexString(static_cast<juce::int64> (key)).paddedLeft('0', 16) + ".irc");
+    }
+
+    bool writePadded(juce::OutputStream& out, const void* data, size_t numBytes)
+    {
+        static const char zeros[16] = {};
+
+        if (numBytes > 0 && ! out.write(data, numBytes))
+            return false;
+
+        const auto padding = alignedSize(static_cast<size_t> (out.getPosition())) - static_cast<size_t> (out.getPosition());
+        return padding == 0 || out.write(zeros, padding);
+    }
+}
+
+uint64_t hashFile(const juce::File& file)
+{
+    juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr || mapped.getSize() == 0)
+        return 0;
+
+    return fnv1a(mapped.getData(), mapped.getSize());
+}
+
+juce::File getDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("BraveLvkai")
+        .getChildFile("IRCache");
+}
+
+uint64_t combine(uint64_t hash, const void* data, size_t numBytes)
+{
+    return fnv1a(data, numBytes, hash);
+}
+
+std::shared_ptr<const PartitionedIR> find(uint64_t contentHash, const EngineSpec& spec,
+                                          juce::AudioBuffer<float>* source, double* sourceSampleRate,
+                                          std::vector<float>* waveform)
+{
+    if (contentHash == 0)
+        return nullptr;
+
+    const auto key = makeKey(contentHash, spec);
+    const auto file = getEntryFile(key);
+    if (! file.existsAsFile())
+        return nullptr;
+
+    juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*> (mapped.getData());
+    const auto fileSize = mapped.getSize();
+    if (data == nullptr || fileSize < sizeof(Header))
+        return nullptr;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != fileMagic || header.version != formatVersion || header.key != key
+        || header.irLength <= 0 || header.numIRChannels < 1 || header.numIRChannels > 4
+        || header.headLength < 0 || header.headLength > header.irLength
+        || header.numStages < 0 || header.numStages > maxNumStages
+        || header.sourceLength <= 0 || header.numSourceChannels <= 0 || ! (header.sourceSampleRate > 0.0)
+        || header.waveformSize < 0)
+        return nullptr;
+
+    auto partitions = std::make_shared<PartitionedIR>();
+    partitions->irLength = header.irLength;
+    partitions->numIRChannels = header.numIRChannels;
+    partitions->scheme.headLength = header.headLength;
+
+    size_t position = sizeof(Header);
+    for (int i = 0; i < header.numStages; ++i)
+    {
+        if (position + sizeof(StageHeader) > fileSize)
+            return nullptr;
+
+        StageHeader stageHeader;
+        std::memcpy(&stageHeader, data + position, sizeof(StageHeader));
+        position += sizeof(StageHeader);
+
+        if (! juce::isPowerOfTwo(stageHeader.partitionSize) || stageHeader.partitionSize > PartitionScheme::maxPartitionSize
+            || stageHeader.offset < stageHeader.partitionSize || stageHeader.numPartitions <= 0)
+            return nullptr;
+
+        partitions->scheme.stages.push_back({ stageHeader.partitionSize, stageHeader.offset, stageHeader.numPartitions });
+    }
+
+    // Every float section has to fit in the file
+    auto takeSection = [&](size_t numFloats) -> const float*
+    {
+        position = alignedSize(position);
+        if (position + numFloats * sizeof(float) > fileSize)
+            return nullptr;
+
+        auto* section = reinterpret_cast<const float*> (data + position);
+        position += numFloats * sizeof(float);
+        return section;
+    };
+
+    const auto* sourceData = takeSection(static_cast<size_t> (header.sourceLength) * static_cast<size_t> (header.numSourceChannels));
+    const auto* waveformData = takeSection(static_cast<size_t> (header.waveformSize));
+    const auto* headTaps = takeSection(partitions->getHeadSize());
+    if (sourceData == nullptr || waveformData == nullptr || headTaps == nullptr)
+        return nullptr;
+
+    std::vector<const float*> stageFilters;
+    size_t totalSize = partitions->getHeadSize();
+    for (size_t i = 0; i < partitions->scheme.stages.size(); ++i)
+    {
+        const auto* filters = takeSection(partitions->getStageSize(i));
+        if (filters == nullptr)
+            return nullptr;
+
+        stageFilters.push_back(filters);
+        totalSize += partitions->getStageSize(i);
+    }
+
+    // Copied out rather than used from the mapping: a mapped page is only
+    // read in when first touched, and the OS may drop it again at any time,
+    // so the audio thread would be the one stalling on the disk
+    partitions->storage.resize(totalSize);
+    float* destination = partitions->storage.data();
+
+    std::memcpy(destination, headTaps, sizeof(float) * partitions->getHeadSize());
+    partitions->headTaps = destination;
+    destination += partitions->getHeadSize();
+
+    for (size_t i = 0; i < stageFilters.size(); ++i)
+    {
+        std::memcpy(destination, stageFilters[i], sizeof(float) * partitions->getStageSize(i));
+        partitions->stageFilters.push_back(destination);
+        destination += partitions->getStageSize(i);
+    }
+
+    if (source != nullptr)
+    {
+        source->setSize(header.numSourceChannels, header.sourceLength);
+        for (int channel = 0; channel < header.numSourceChannels; ++channel)
+            source->copyFrom(channel, 0, sourceData + channel * header.sourceLength, header.sourceLength);
+    }
+
+    if (sourceSampleRate != nullptr)
+        *sourceSampleRate = header.sourceSampleRate;
+
+    if (waveform != nullptr)
+        waveform->assign(waveformData, waveformData + header.waveformSize);
+
+    // Marks the entry as recently used for trim
+    file.setLastModificationTime(juce::Time::getCurrentTime());
+    return partitions;
+}
+
+bool store(uint64_t contentHash, const EngineSpec& spec,
+           const juce::AudioBuffer<float>& source, double sourceSampleRate,
+           const std::vector<float>& waveform, const PartitionedIR& partitions)
+{
+    if (contentHash == 0 || source.getNumSamples() == 0)
+        return false;
+
+    const auto key = makeKey(contentHash, spec);
+    const auto target = getEntryFile(key);
+    if (! target.getParentDirectory().createDirectory().wasOk())
+        return false;
+
+    Header header{};
+    header.magic = fileMagic;
+    header.version = formatVersion;
+    header.key = key;
+    header.irLength = partitions.irLength;
+    header.numIRChannels = partitions.numIRChannels;
+    header.headLength = partitions.scheme.headLength;
+    header.numStages = static_cast<int32_t> (partitions.scheme.stages.size());
+    header.sourceLength = source.getNumSamples();
+    header.numSourceChannels = source.getNumChannels();
+    header.waveformSize = static_cast<int32_t> (waveform.size());
+    header.sourceSampleRate = sourceSampleRate;
+
+    juce::TemporaryFile temporary(target);
+    {
+        juce::FileOutputStream out(temporary.getFile());
+        if (! out.openedOk() || ! out.write(&header, sizeof(Header)))
+            return false;
+
+        for (const auto& stage : partitions.scheme.stages)
+        {
+            const StageHeader stageHeader{ stage.partitionSize, stage.offset, stage.numPartitions, 0 };
+            if (! out.write(&stageHeader, sizeof(StageHeader)))
+                return false;
+        }
+
+        if (! writePadded(out, nullptr, 0))
+            return false;
+
+        for (int channel = 0; channel < source.getNumChannels(); ++channel)
+            if (! out.write(source.getReadPointer(channel), sizeof(float) * static_cast<size_t> (source.getNumSamples())))
+                return false;
+
+        if (! writePadded(out, nullptr, 0)
+            || ! writePadded(out, waveform.data(), sizeof(float) * waveform.size())
+            || ! writePadded(out, partitions.headTaps, sizeof(float) * partitions.getHeadSize()))
+            return false;
+
+        for (size_t i = 0; i < partitions.scheme.stages.size(); ++i)
+            if (! writePadded(out, partitions.stageFilters[i], sizeof(float) * partitions.getStageSize(i)))
+                return false;
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+        return false;
+
+    trim(maxTotalBytes);
+    return true;
+}
+
+void trim(juce::int64 maxBytes)
+{
+    auto entries = getDirectory().findChildFiles(juce::File::findFiles, false, "*.irc");
+
+    // Most recently used first; find refreshes an entry's modification time
+    std::sort(entries.begin(), entries.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() > b.getLastModificationTime();
+    });
+
+    juce::int64 totalBytes = 0;
+    for (const auto& entry : entries)
+    {
+        totalBytes += entry.getSize();
+        if (totalBytes > maxBytes)
+            entry.deleteFile();
+    }
+}
+}
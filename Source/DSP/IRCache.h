@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    IRCache.h
+    Created: 17 Oct 2026 6:21:40pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PartitionedConvolver.h"
+#include "IRLoader.h"
+
+// Transformed IRs kept on disk, so reopening a session or going back to a
+// sample rate skips the decode, trim and FFT work. Entries are keyed by a
+// hash of the IR file's contents plus everything that shapes the partitions
+// (sample rate, block size, channel layout, length cap, lead frame). A hit is
+// read with a memory mapping and its spectra copied out, which is still far
+// cheaper than rebuilding them. The directory is held to maxTotalBytes by
+// dropping the least recently used entries.
+//
+// File layout: a Header, one StageHeader per stage, the trimmed IR at the
+// file's own rate (so edits can be redone from it), the display waveform
+// of the rendered IR (so a hit needs no render), the head taps, then each
+// stage's spectra, every section starting 16-byte aligned.
+namespace IRCache
+{
+    // FNV-1a over the file's bytes; 0 if it can't be read, which disables
+    // caching for that file
+    uint64_t hashFile(const juce::File& file);
+
+    // Folds more data (such as IR edit settings) into a content hash
+    uint64_t combine(uint64_t hash, const void* data, size_t numBytes);
+
+    juce::File getDirectory();
+
+    constexpr juce::int64 maxTotalBytes = 512 * 1024 * 1024;
+
+    // The cached partitions, or nullptr on a miss. Never throws or asserts
+    // on a bad file; anything that doesn't match is simply a miss. Pass
+    // source to also get the trimmed IR the entry was made from, and
+    // waveform to get the stored display waveform.
+    std::shared_ptr<const PartitionedIR> find(uint64_t contentHash, const EngineSpec& spec,
+                                              juce::AudioBuffer<float>* source = nullptr, double* sourceSampleRate = nullptr,
+                                              std::vector<float>* waveform = nullptr);
+
+    // Written to a temporary file and moved into place, so a reader never
+    // sees half an entry. Trims the cache afterwards.
+    bool store(uint64_t contentHash, const EngineSpec& spec,
+               const juce::AudioBuffer<float>& source, double sourceSampleRate,
+               const std::vector<float>& waveform, const PartitionedIR& partitions);
+
+    // Deletes the least recently used entries until the rest fit in maxBytes
+    void trim(juce::int64 maxBytes);
+}
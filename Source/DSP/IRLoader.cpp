@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    IRLoader.cpp
+    Created: 17 Oct 2026 5:02:51pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "IRLoader.h"
+
+namespace
+{
+    struct TrimRange
+    {
+        int start, length;
+    };
+
+    // blockPeaks holds the magnitude of every whole 10 ms block; the IR is
+    // trimmed to the blocks that reach 0.001 once scaled by gain
+    TrimRange findTrimRange(const std::vector<float>& blockPeaks, float gain, int blockSize, int numSamples)
+    {
+        int startBlockNum = 0;
+        int endBlockNum = numSamples / blockSize;
+
+        // Find the first sample in the IR signal that is greater than 0.001
+        while ((startBlockNum + 1) * blockSize < numSamples)
+        {
+            if (blockPeaks[static_cast<size_t>(startBlockNum)] * gain > 0.001)
+            {
+                break;
+            }
+            ++startBlockNum;
+        }
+
+        // Find the last sample in the IR signal that is greater than 0.001
+        while ((endBlockNum - 1) * blockSize > 0)
+        {
+            --endBlockNum;
+            if (blockPeaks[static_cast<size_t>(endBlockNum)] * gain > 0.001)
+            {
+                break;
+            }
+        }
+
+        // Calculate the length of the cropped IR signal
+        int trimmedNumSamples;
+        // If the tail has been clipped
+        if (endBlockNum * blockSize < numSamples)
+        {
+            trimmedNumSamples = (endBlockNum - startBlockNum) * blockSize - 1;
+        }
+        else
+        {
+            trimmedNumSamples = numSamples - startBlockNum * blockSize;
+        }
+
+        // An IR that is silent throughout is kept as it is
+        if (trimmedNumSamples <= 0)
+            return { 0, numSamples };
+
+        return { startBlockNum * blockSize, trimmedNumSamples };
+    }
+}
+
+bool IRProcessing::readFile(juce::AudioFormatManager& formatManager, const juce::File& file, juce::AudioBuffer<float>& ir, double& sampleRate)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(formatManager.createMemoryMappedReader(file));
+    if (mappedReader != nullptr && mappedReader->mapEntireFile())
+        reader = std::move(mappedReader);
+    else
+        reader.reset(formatManager.createReaderFor(file));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return false;
+
+    sampleRate = reader->sampleRate;
+    const int numChannels = static_cast<int>(reader->numChannels);
+    const int numSamples = static_cast<int>(reader->lengthInSamples);
+    const int blockSize = juce::jmax(1, static_cast<int>(std::floor(sampleRate) / 100));
+
+    // Pass one: the global peak and the peak of every whole 10 ms block
+    std::vector<float> blockPeaks(static_cast<size_t>(numSamples / blockSize));
+    const int blocksPerChunk = juce::jmax(1, chunkSize / blockSize);
+    juce::AudioBuffer<float> chunk(numChannels, blocksPerChunk * blockSize);
+    float globalMaxMagnitude = 0.0f;
+
+    for (int start = 0; start < numSamples; start += chunk.getNumSamples())
+    {
+        const int length = juce::jmin(chunk.getNumSamples(), numSamples - start);
+        if (! reader->read(&chunk, 0, length, start, true, true))
+            return false;
+
+        globalMaxMagnitude = juce::jmax(globalMaxMagnitude, chunk.getMagnitude(0, length));
+
+        for (int offset = 0; offset + blockSize <= length; offset += blockSize)
+            blockPeaks[static_cast<size_t>((start + offset) / blockSize)] = chunk.getMagnitude(offset, blockSize);
+    }
+
+    // Nomalize IR signal
+    const float gain = 1.0f / (globalMaxMagnitude + 0.01f);
+    const auto range = findTrimRange(blockPeaks, gain, blockSize, numSamples);
+
+    // Pass two: only the trimmed range, straight into its final buffer
+    ir.setSize(numChannels, range.length);
+    if (! reader->read(&ir, 0, range.length, range.start, true, true))
+        return false;
+
+    ir.applyGain(gain);
+    return true;
+}
+
+std::shared_ptr<const PartitionedIR> IRProcessing::partition(const juce::AudioBuffer<float>& ir, const EngineSpec& spec)
+{
+    // Cheaper profiles cap the IR length and fade out what is left of the tail
+    const int maxLength = juce::roundToInt(spec.quality.maxIRLengthSeconds * spec.sampleRate);
+    const bool isCapped = maxLength > 0 && ir.getNumSamples() > maxLength;
+    const int length = isCapped ? maxLength : ir.getNumSamples();
+    const int fadeLength = isCapped ? juce::jmin(maxLength, juce::roundToInt(spec.sampleRate / 20)) : 0;
+    const int fadeStart = length - fadeLength;
+
+    const int numIRChannels = PartitionedIR::getNumIRChannels(ir.getNumChannels(), spec.numChannels);
+    PartitionedIRBuilder builder(length, numIRChannels, spec.maxBlockSize, spec.quality.deferConvolutionTail);
+    juce::AudioBuffer<float> chunk(numIRChannels, juce::jmin(chunkSize, length));
+    float energies[4] = {};
+
+    for (int start = 0; start < length; start += chunk.getNumSamples())
+    {
+        const int todo = juce::jmin(chunk.getNumSamples(), length - start);
+
+        for (int channel = 0; channel < numIRChannels; ++channel)
+        {
+            float* samples = chunk.getWritePointer(channel);
+            juce::FloatVectorOperations::copy(samples, ir.getReadPointer(channel, start), todo);
+
+            for (int i = juce::jmax(0, fadeStart - start); i < todo; ++i)
+                samples[i] *= 1.0f - static_cast<float>(start + i - fadeStart) / static_cast<float>(fadeLength);
+
+            energies[channel] += std::inner_product(samples, samples + todo, samples, 0.0f);
+        }
+
+        builder.append(chunk.getArrayOfReadPointers(), todo);
+    }
+
+    // Normalise by energy, as juce::dsp::Convolution did. A true-stereo IR
+    // feeds each output from two channels (LL + RL, LR + RR), so the energy
+    // is taken per output rather than per channel. The partitions are linear
+    // in the IR, so the gain is applied to them once at the end.
+    float maxEnergy = 0.0f;
+    if (numIRChannels == 4)
+        maxEnergy = juce::jmax(energies[0] + energies[2], energies[1] + energies[3]);
+    else
+        maxEnergy = juce::jmax(energies[0], energies[1]);
+
+    return builder.finish(maxEnergy > 0.0f ? 1.0f / std::sqrt(maxEnergy) : 1.0f);
+}
+
+//==============================================================================
+IRLoader::IRLoader(std::function<void()> idleCallback)
+    : juce::Thread("IR Loader"),
+      onIdle(std::move(idleCallback))
+{
+    startThread();
+}
+
+IRLoader::~IRLoader()
+{
+    stop();
+}
+
+void IRLoader::post(Job job)
+{
+    {
+        const juce::ScopedLock lock(jobLock);
+        pendingJob = std::move(job);
+    }
+
+    notify();
+}
+
+void IRLoader::stop()
+{
+    stopThread(4000);
+}
+
+void IRLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        Job job;
+        {
+            const juce::ScopedLock lock(jobLock);
+            std::swap(job, pendingJob);
+        }
+
+        if (job != nullptr)
+        {
+            job();
+            continue;
+        }
+
+        onIdle();
+        wait(idleIntervalMs);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    IRLoader.h
+    Created: 17 Oct 2026 5:02:51pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../Utils/QualityProfile.h"
+#include "PartitionedConvolver.h"
+
+// Everything a convolution engine is built for
+struct EngineSpec
+{
+    double sampleRate = 48000.0;
+    int maxBlockSize = 512;
+    int numChannels = 2;
+    QualityProfile quality{ QualityProfile::realtime() };
+
+    bool operator== (const EngineSpec& other) const
+    {
+        return sampleRate == other.sampleRate
+            && maxBlockSize == other.maxBlockSize
+            && numChannels == other.numChannels
+            && quality == other.quality;
+    }
+
+    bool operator!= (const EngineSpec& other) const { return ! operator== (other); }
+};
+
+namespace IRProcessing
+{
+    // Samples read or partitioned at a time while streaming
+    constexpr int chunkSize = 65536;
+
+    // Reads the file peak-normalised, with the near-silent 10 ms blocks at
+    // either end trimmed off, at the file's own sample rate. The file is
+    // streamed twice, memory-mapped when the format allows it: once in chunks
+    // for the peak and the trim points, then straight into ir, so only the
+    // trimmed IR is ever held in memory.
+    bool readFile(juce::AudioFormatManager& formatManager, const juce::File& file, juce::AudioBuffer<float>& ir, double& sampleRate);
+
+    // Caps the IR to the quality profile, normalises it by energy and
+    // partitions it, a chunk at a time. Allocates and runs FFTs, so never on
+    // the audio thread.
+    std::shared_ptr<const PartitionedIR> partition(const juce::AudioBuffer<float>& ir, const EngineSpec& spec);
+}
+
+// The thread IR work runs on. It holds one job at a time: posting a new one
+// replaces a job that has not started yet, so only the latest of a quick run
+// of loads is done. onIdle is called between jobs, every few tens of
+// milliseconds, so the owner can free anything the audio thread handed back.
+class IRLoader : private juce::Thread
+{
+public:
+    using Job = std::function<void()>;
+
+    explicit IRLoader(std::function<void()> onIdle);
+    ~IRLoader() override;
+
+    void post(Job job);
+
+    // Stops the thread; nothing is called on it after this returns
+    void stop();
+
+private:
+    void run() override;
+
+    std::function<void()> onIdle;
+
+    juce::CriticalSection jobLock;
+    Job pendingJob;
+
+    static constexpr int idleIntervalMs = 50;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRLoader)
+};
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    IRPipeline.cpp
+    Created: 17 Oct 2026 8:05:13pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "IRPipeline.h"
+
+void IRPipeline::setSource(juce::AudioBuffer<float> newSource, double newSourceSampleRate)
+{
+    source = std::move(newSource);
+    sourceSampleRate = newSourceSampleRate;
+
+    atSessionRate = nullptr;
+    resampledRate = 0.0;
+    isEditedCurrent = false;
+}
+
+const juce::AudioBuffer<float>& IRPipeline::render(double sampleRate, const IREdits& edits)
+{
+    jassert(hasSource());
+
+    if (atSessionRate == nullptr || resampledRate != sampleRate)
+    {
+        resample(sampleRate);
+        isEditedCurrent = false;
+    }
+
+    if (! isEditedCurrent || ! editedWith.rendersLike(edits))
+    {
+        applyEdits(edits);
+        editedWith = edits;
+        isEditedCurrent = true;
+    }
+
+    return edited;
+}
+
+void IRPipeline::resample(double sampleRate)
+{
+    resampledRate = sampleRate;
+
+    if (sourceSampleRate <= 0.0 || sourceSampleRate == sampleRate)
+    {
+        resampled.setSize(0, 0);
+        atSessionRate = &source;
+        return;
+    }
+
+    const double speedRatio = sourceSampleRate / sampleRate;
+    const int numSamples = juce::jmax(1, static_cast<int>(source.getNumSamples() / speedRatio));
+    resampled.setSize(source.getNumChannels(), numSamples);
+
+    // Going up, there is nothing above the new Nyquist to fold back
+    juce::AudioBuffer<float> bandLimited;
+    if (speedRatio > 1.0)
+        bandLimited = bandLimit(source, sourceSampleRate, sampleRate);
+    const auto& input = speedRatio > 1.0 ? bandLimited : source;
+
+    for (int channel = 0; channel < input.getNumChannels(); ++channel)
+    {
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process(speedRatio, input.getReadPointer(channel), resampled.getWritePointer(channel),
+                             numSamples, input.getNumSamples(), 0);
+    }
+
+    atSessionRate = &resampled;
+}
+
+juce::AudioBuffer<float> IRPipeline::bandLimit(const juce::AudioBuffer<float>& input, double inputSampleRate, double sampleRate)
+{
+    // Flat to 90% of the new Nyquist and 90 dB down by the Nyquist itself
+    const double nyquist = sampleRate / 2.0;
+    const auto coefficients = juce::dsp::FilterDesign<float>::designFIRLowpassKaiserMethod(
+        static_cast<float>(0.95 * nyquist), inputSampleRate, static_cast<float>(0.1 * nyquist / inputSampleRate), -90.0f);
+
+    const float* taps = coefficients->getRawCoefficients();
+    const int numTaps = static_cast<int>(coefficients->getFilterOrder()) + 1;
+    const int numSamples = input.getNumSamples();
+
+    // Overlap-add with transforms a few times the filter's length, so the
+    // cost per sample follows log(taps) rather than taps
+    const int fftOrder = juce::jmax(10, static_cast<int>(std::ceil(std::log2(4.0 * numTaps))));
+    const int fftSize = 1 << fftOrder;
+    const int blockSize = fftSize - numTaps + 1;
+    const int spectrumSize = fftSize + 2;
+    juce::dsp::FFT fft(fftOrder);
+
+    std::vector<float> kernel(static_cast<size_t>(2 * fftSize), 0.0f);
+    std::copy(taps, taps + numTaps, kernel.begin());
+    fft.performRealOnlyForwardTransform(kernel.data(), true);
+
+    // The filter is symmetric, so reading the full convolution from its
+    // centre on keeps the IR where it was (to within half an input sample
+    // for an odd order)
+    const int centre = numTaps / 2;
+    juce::AudioBuffer<float> output(input.getNumChannels(), numSamples);
+    output.clear();
+    std::vector<float> work(static_cast<size_t>(2 * fftSize));
+
+    for (int channel = 0; channel < input.getNumChannels(); ++channel)
+    {
+        const float* in = input.getReadPointer(channel);
+        float* out = output.getWritePointer(channel);
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            const int todo = juce::jmin(blockSize, numSamples - start);
+            std::fill(work.begin(), work.end(), 0.0f);
+            std::copy(in + start, in + start + todo, work.begin());
+            fft.performRealOnlyForwardTransform(work.data(), true);
+
+            for (int bin = 0; bin < spectrumSize; bin += 2)
+            {
+                const float re = work[static_cast<size_t>(bin)], im = work[static_cast<size_t>(bin + 1)];
+                const float kernelRe = kernel[static_cast<size_t>(bin)], kernelIm = kernel[static_cast<size_t>(bin + 1)];
+                work[static_cast<size_t>(bin)] = re * kernelRe - im * kernelIm;
+                work[static_cast<size_t>(bin + 1)] = re * kernelIm + im * kernelRe;
+            }
+
+            fft.performRealOnlyInverseTransform(work.data());
+
+            // Full-convolution sample start + i lands on output sample start + i - centre
+            const int first = juce::jmax(0, centre - start);
+            const int last = juce::jmin(todo + numTaps - 1, numSamples + centre - start);
+            if (last > first)
+                juce::FloatVectorOperations::add(out + start + first - centre, work.data() + first, last - first);
+        }
+    }
+
+    return output;
+}
+
+void IRPipeline::applyEdits(const IREdits& edits)
+{
+    const auto& input = *atSessionRate;
+    const int numSamples = input.getNumSamples();
+
+    edited.setSize(input.getNumChannels(), numSamples, false, false, true);
+
+    for (int channel = 0; channel < input.getNumChannels(); ++channel)
+        juce::FloatVectorOperations::copy(edited.getWritePointer(channel), input.getReadPointer(channel), numSamples);
+
+    // Decay envelope, on the IR as recorded (so before any reverse):
+    // gain(n) = ratio^n, from 0 dB down to 60 * (1 - decay) / decay dB below
+    // at the last sample. One chunk of the curve is worked out and scaled for
+    // each chunk after it, then everything past -140 dB is cleared.
+    if (edits.decay < 1.0f)
+    {
+        const float decay = juce::jmax(edits.decay, 0.01f);
+        const double attenuationDb = 60.0 * (1.0 - decay) / decay;
+        const double logRatio = -attenuationDb / 20.0 * std::log(10.0) / juce::jmax(1, numSamples);
+
+        envelope.resize(static_cast<size_t>(envelopeChunkSize));
+        for (int i = 0; i < envelopeChunkSize; ++i)
+            envelope[static_cast<size_t>(i)] = static_cast<float>(std::exp(logRatio * i));
+
+        for (int start = 0; start < numSamples; start += envelopeChunkSize)
+        {
+            const int todo = juce::jmin(envelopeChunkSize, numSamples - start);
+            const auto chunkGain = static_cast<float>(std::exp(logRatio * start));
+
+            for (int channel = 0; channel < edited.getNumChannels(); ++channel)
+            {
+                float* samples = edited.getWritePointer(channel, start);
+
+                if (chunkGain < 1.0e-7f)
+                {
+                    juce::FloatVectorOperations::clear(samples, numSamples - start);
+                    continue;
+                }
+
+                juce::FloatVectorOperations::multiply(samples, envelope.data(), todo);
+                juce::FloatVectorOperations::multiply(samples, chunkGain, todo);
+            }
+
+            if (chunkGain < 1.0e-7f)
+                break;
+        }
+    }
+
+    if (edits.reverse)
+        for (int channel = 0; channel < edited.getNumChannels(); ++channel)
+            edited.reverse(channel, 0, numSamples);
+}
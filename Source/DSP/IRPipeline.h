@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    IRPipeline.h
+    Created: 17 Oct 2026 8:05:13pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// User edits to the loaded IR
+struct IREdits
+{
+    bool reverse = false;
+
+    // 1 leaves the tail as it is; lower values fade it out over the IR's
+    // length, reaching -60 dB by the end at 0.5
+    float decay = 1.0f;
+
+    // Applied by delaying the engine's input rather than by padding the IR,
+    // so moving it never re-renders or re-partitions anything
+    float preDelaySeconds = 0.0f;
+    static constexpr float maxPreDelaySeconds = 0.2f;
+
+    // Whether the rendered IR would be the same; only reverse and decay
+    // change it
+    bool rendersLike(const IREdits& other) const
+    {
+        return reverse == other.reverse && decay == other.decay;
+    }
+
+    bool operator== (const IREdits& other) const
+    {
+        return reverse == other.reverse
+            && decay == other.decay
+            && preDelaySeconds == other.preDelaySeconds;
+    }
+
+    bool operator!= (const IREdits& other) const { return ! operator== (other); }
+};
+
+// Takes the trimmed, normalised IR through resampling to the session rate,
+// then the decay envelope and reverse. The resampled IR and the
+// finished one are both kept, so sweeping an edit only redoes the cheap
+// vector passes, and a new sample rate only redoes what follows it.
+// Not thread-safe; the owner serialises access.
+class IRPipeline
+{
+public:
+    void setSource(juce::AudioBuffer<float> newSource, double newSourceSampleRate);
+    bool hasSource() const { return source.getNumSamples() > 0; }
+
+    const juce::AudioBuffer<float>& getSource() const { return source; }
+    double getSourceSampleRate() const { return sourceSampleRate; }
+
+    // Brings the stages up to date for sampleRate and edits and returns the
+    // finished IR
+    const juce::AudioBuffer<float>& render(double sampleRate, const IREdits& edits);
+
+private:
+    void resample(double sampleRate);
+    void applyEdits(const IREdits& edits);
+
+    // Low-passes input below the session's Nyquist, with the filter's delay
+    // taken out, so that resampling down doesn't fold the top octave back in
+    static juce::AudioBuffer<float> bandLimit(const juce::AudioBuffer<float>& input, double inputSampleRate, double sampleRate);
+
+    juce::AudioBuffer<float> source;
+    double sourceSampleRate = 0.0;
+
+    // Stage one: source at the session rate (or source itself, if the rates match)
+    juce::AudioBuffer<float> resampled;
+    const juce::AudioBuffer<float>* atSessionRate = nullptr;
+    double resampledRate = 0.0;
+
+    // Stage two: decayed and reversed
+    juce::AudioBuffer<float> edited;
+    IREdits editedWith;
+    bool isEditedCurrent = false;
+
+    // One chunk of the decay curve, scaled per chunk
+    std::vector<float> envelope;
+    static constexpr int envelopeChunkSize = 4096;
+};
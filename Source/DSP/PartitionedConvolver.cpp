@@ -0,0 +1,452 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.cpp
+    Created: 17 Oct 2026 3:10:27pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolver.h"
+
+PartitionScheme PartitionScheme::create(int maxBlockSize, int irLength, bool withLeadFrame)
+{
+    PartitionScheme scheme;
+
+    const int firstSize = juce::jlimit(minHeadLength, maxHeadLength, juce::nextPowerOfTwo(juce::jmax(1, maxBlockSize)) / 8);
+    const int largestSize = juce::jlimit(firstSize, maxPartitionSize, juce::nextPowerOfTwo(juce::jmax(1, irLength / 16)));
+
+    scheme.headLength = juce::jmin(firstSize, irLength);
+
+    int size = firstSize;
+    int offset = firstSize;
+    while (offset < irLength)
+    {
+        const int nextSize = juce::jmin(size * growthRatio, largestSize);
+
+        // Run up to where the next, larger stage can take over, or to the end
+        int end = irLength;
+        if (nextSize > size)
+        {
+            const int minOffset = withLeadFrame && nextSize >= 2 * maxBlockSize ? 2 * nextSize : nextSize;
+            const int nextOffset = juce::jmax(minOffset, (offset + size + nextSize - 1) / nextSize * nextSize);
+            end = juce::jmin(end, nextOffset);
+        }
+
+        Stage stage;
+        stage.partitionSize = size;
+        stage.offset = offset;
+        stage.numPartitions = (end - offset + size - 1) / size;
+        scheme.stages.push_back(stage);
+
+        offset += stage.numPartitions * size;
+        size = nextSize;
+    }
+
+    return scheme;
+}
+
+//==============================================================================
+size_t PartitionedIR::getHeadSize() const
+{
+    return static_cast<size_t> (numIRChannels) * static_cast<size_t> (scheme.headLength);
+}
+
+size_t PartitionedIR::getStageSize(size_t stage) const
+{
+    const auto& layout = scheme.stages[stage];
+    return static_cast<size_t> (numIRChannels) * static_cast<size_t> (layout.numPartitions)
+         * static_cast<size_t> (getSpectrumSize(layout.partitionSize));
+}
+
+int PartitionedIR::getNumIRChannels(int numFileChannels, int numChannels)
+{
+    if (numFileChannels >= 4 && numChannels == 2)
+        return 4;
+
+    return juce::jlimit(1, 2, numFileChannels);
+}
+
+std::shared_ptr<const PartitionedIR> PartitionedIR::transform(const juce::AudioBuffer<float>& ir, int maxBlockSize, int numChannels,
+                                                              bool withLeadFrame)
+{
+    PartitionedIRBuilder builder(ir.getNumSamples(), getNumIRChannels(ir.getNumChannels(), numChannels), maxBlockSize, withLeadFrame);
+    builder.append(ir.getArrayOfReadPointers(), ir.getNumSamples());
+    return builder.finish();
+}
+
+//==============================================================================
+PartitionedIRBuilder::PartitionedIRBuilder(int irLength, int numIRChannels, int maxBlockSize, bool withLeadFrame)
+    : partitions(std::make_shared<PartitionedIR>())
+{
+    jassert(irLength > 0 && numIRChannels > 0);
+
+    partitions->irLength = irLength;
+    partitions->numIRChannels = numIRChannels;
+    partitions->scheme = PartitionScheme::create(maxBlockSize, irLength, withLeadFrame);
+
+    size_t totalSize = partitions->getHeadSize();
+    for (size_t i = 0; i < partitions->scheme.stages.size(); ++i)
+        totalSize += partitions->getStageSize(i);
+    partitions->storage.resize(totalSize);
+
+    float* data = partitions->storage.data();
+    partitions->headTaps = data;
+    data += partitions->getHeadSize();
+
+    for (size_t i = 0; i < partitions->scheme.stages.size(); ++i)
+    {
+        stageData.push_back(data);
+        partitions->stageFilters.push_back(data);
+        data += partitions->getStageSize(i);
+    }
+
+    if (! partitions->scheme.stages.empty())
+    {
+        const int largestSize = partitions->scheme.stages.back().partitionSize;
+        frames.setSize(numIRChannels, largestSize);
+        frames.clear();
+        work.resize(static_cast<size_t> (4 * largestSize));
+        fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * partitions->scheme.stages.front().partitionSize)));
+    }
+}
+
+void PartitionedIRBuilder::append(const float* const* channels, int numSamples)
+{
+    const int numIRChannels = partitions->numIRChannels;
+    const int headLength = partitions->scheme.headLength;
+    numSamples = juce::jmin(numSamples, partitions->irLength - position);
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        // Direct-form head
+        if (position < headLength)
+        {
+            const int todo = juce::jmin(numSamples - done, headLength - position);
+            for (int channel = 0; channel < numIRChannels; ++channel)
+                juce::FloatVectorOperations::copy(partitions->storage.data() + channel * headLength + position, channels[channel] + done, todo);
+
+            position += todo;
+            done += todo;
+            continue;
+        }
+
+        const int size = partitions->scheme.stages[stage].partitionSize;
+        const int todo = juce::jmin(numSamples - done, size - framePosition);
+        for (int channel = 0; channel < numIRChannels; ++channel)
+            juce::FloatVectorOperations::copy(frames.getWritePointer(channel, framePosition), channels[channel] + done, todo);
+
+        framePosition += todo;
+        position += todo;
+        done += todo;
+
+        if (framePosition == size)
+            transformPartition();
+    }
+}
+
+void PartitionedIRBuilder::transformPartition()
+{
+    const auto& layout = partitions->scheme.stages[stage];
+    const int size = layout.partitionSize;
+    const int spectrumSize = PartitionedIR::getSpectrumSize(size);
+
+    // Each partition is zero-padded to twice its size
+    for (int channel = 0; channel < partitions->numIRChannels; ++channel)
+    {
+        std::fill(work.begin(), work.end(), 0.0f);
+        juce::FloatVectorOperations::copy(work.data(), frames.getReadPointer(channel), framePosition);
+
+        fft->performRealOnlyForwardTransform(work.data(), true);
+        juce::FloatVectorOperations::copy(stageData[stage] + (channel * layout.numPartitions + partition) * spectrumSize,
+                                          work.data(), spectrumSize);
+    }
+
+    framePosition = 0;
+    if (++partition == layout.numPartitions && stage + 1 < partitions->scheme.stages.size())
+    {
+        partition = 0;
+        ++stage;
+        fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * partitions->scheme.stages[stage].partitionSize)));
+    }
+}
+
+std::shared_ptr<const PartitionedIR> PartitionedIRBuilder::finish(float gain)
+{
+    // The last partition is usually only partly filled
+    if (framePosition > 0)
+        transformPartition();
+
+    if (gain != 1.0f)
+        juce::FloatVectorOperations::multiply(partitions->storage.data(), gain, static_cast<int> (partitions->storage.size()));
+
+    return std::move(partitions);
+}
+
+//==============================================================================
+PartitionedConvolver::PartitionedConvolver(const juce::AudioBuffer<float>& ir, int newMaxBlockSize, int numChannels)
+    : PartitionedConvolver(PartitionedIR::transform(ir, newMaxBlockSize, numChannels), newMaxBlockSize, numChannels)
+{
+}
+
+PartitionedConvolver::PartitionedConvolver(std::shared_ptr<const PartitionedIR> newPartitions, int newMaxBlockSize, int numChannels,
+                                           TailWorker* tailWorker)
+    : partitions(std::move(newPartitions)),
+      maxBlockSize(juce::jmax(1, newMaxBlockSize)),
+      numInputs(numChannels),
+      numOutputs(numChannels),
+      worker(tailWorker)
+{
+    jassert(partitions != nullptr);
+    const int numIRChannels = partitions->numIRChannels;
+
+    if (numIRChannels == 4 && numChannels == 2)
+    {
+        paths = { { 0, 0, 0 }, { 0, 1, 1 }, { 1, 0, 2 }, { 1, 1, 3 } };
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            paths.push_back({ channel, channel, juce::jmin(channel, numIRChannels - 1) });
+    }
+
+    headLength = partitions->scheme.headLength;
+    headHistory.setSize(numInputs, juce::jmax(1, headLength) - 1 + maxBlockSize);
+    output.setSize(numOutputs, maxBlockSize);
+
+    stages.resize(partitions->scheme.stages.size());
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        auto& stage = stages[i];
+        stage.layout = partitions->scheme.stages[i];
+
+        const int size = stage.layout.partitionSize;
+        stage.numBins = size + 1;
+        stage.fdlLength = stage.layout.offset / size - 1 + stage.layout.numPartitions;
+        stage.fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * size)));
+
+        stage.inputFrames.setSize(numInputs, 2 * size);
+        stage.spectra.setSize(numInputs, stage.fdlLength * 2 * stage.numBins);
+        stage.outputFrames.setSize(numOutputs, size);
+        stage.filters = partitions->stageFilters[i];
+        stage.work.resize(static_cast<size_t> (4 * size));
+
+        if (worker != nullptr && PartitionScheme::canDefer(stage.layout, maxBlockSize))
+        {
+            stage.job = std::make_unique<FrameJob>(*this, stage);
+            stage.jobInput.setSize(numInputs, 2 * size);
+            stage.nextOutputFrames.setSize(numOutputs, size);
+        }
+    }
+
+    reset();
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+    for (auto& stage : stages)
+        if (stage.job != nullptr)
+            TailWorker::release(*stage.job);
+}
+
+void PartitionedConvolver::reset()
+{
+    headHistory.clear();
+
+    for (auto& stage : stages)
+    {
+        if (stage.job != nullptr)
+        {
+            TailWorker::finish(*stage.job);
+            stage.nextOutputFrames.clear();
+        }
+
+        stage.inputFrames.clear();
+        stage.spectra.clear();
+        stage.outputFrames.clear();
+        stage.fdlPosition = 0;
+        stage.framePosition = 0;
+    }
+}
+
+void PartitionedConvolver::process(juce::dsp::AudioBlock<float>& block)
+{
+    const int numChannels = juce::jmin(static_cast<int> (block.getNumChannels()), numInputs);
+    const int totalNumSamples = static_cast<int> (block.getNumSamples());
+
+    for (int start = 0; start < totalNumSamples; start += maxBlockSize)
+    {
+        const int numSamples = juce::jmin(maxBlockSize, totalNumSamples - start);
+        const int historyLength = headHistory.getNumSamples() - maxBlockSize;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            headHistory.copyFrom(channel, historyLength, block.getChannelPointer(static_cast<size_t> (channel)) + start, numSamples);
+
+        processHead(numSamples);
+
+        for (auto& stage : stages)
+            processStage(stage, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            juce::FloatVectorOperations::copy(block.getChannelPointer(static_cast<size_t> (channel)) + start, output.getReadPointer(channel), numSamples);
+
+            // Keep the newest samples for the head of the next block
+            float* history = headHistory.getWritePointer(channel);
+            std::memmove(history, history + numSamples, sizeof(float) * static_cast<size_t> (historyLength));
+        }
+    }
+}
+
+void PartitionedConvolver::processHead(int numSamples)
+{
+    const int historyLength = headHistory.getNumSamples() - maxBlockSize;
+    output.clear();
+
+    for (const auto& path : paths)
+    {
+        const float* taps = partitions->headTaps + path.irChannel * headLength;
+        const float* history = headHistory.getReadPointer(path.input);
+        float* out = output.getWritePointer(path.output);
+
+        // y[n] += h[k] * x[n - k], one vector operation per tap
+        for (int k = 0; k < headLength; ++k)
+            juce::FloatVectorOperations::addWithMultiply(out, history + historyLength - k, taps[k], numSamples);
+    }
+}
+
+void PartitionedConvolver::processStage(Stage& stage, int numSamples)
+{
+    const int size = stage.layout.partitionSize;
+    const int historyLength = headHistory.getNumSamples() - maxBlockSize;
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        const int todo = juce::jmin(numSamples - done, size - stage.framePosition);
+
+        for (int channel = 0; channel < numInputs; ++channel)
+            juce::FloatVectorOperations::copy(stage.inputFrames.getWritePointer(channel, size + stage.framePosition),
+                                              headHistory.getReadPointer(channel, historyLength + done), todo);
+
+        for (int channel = 0; channel < numOutputs; ++channel)
+            juce::FloatVectorOperations::add(output.getWritePointer(channel, done),
+                                             stage.outputFrames.getReadPointer(channel, stage.framePosition), todo);
+
+        stage.framePosition += todo;
+        done += todo;
+
+        if (stage.framePosition == size)
+        {
+            if (stage.job != nullptr)
+                startDeferredFrame(stage);
+            else
+                processFrame(stage);
+
+            stage.framePosition = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processFrame(Stage& stage)
+{
+    transformInput(stage, stage.inputFrames);
+
+    for (int channel = 0; channel < numInputs; ++channel)
+    {
+        float* frames = stage.inputFrames.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(frames, frames + stage.layout.partitionSize, stage.layout.partitionSize);
+    }
+
+    computeOutput(stage, 0, stage.outputFrames);
+}
+
+void PartitionedConvolver::startDeferredFrame(Stage& stage)
+{
+    const int size = stage.layout.partitionSize;
+
+    // The frame posted last time is due now; usually the worker has long
+    // finished it
+    TailWorker::finish(*stage.job);
+    std::swap(stage.outputFrames, stage.nextOutputFrames);
+
+    for (int channel = 0; channel < numInputs; ++channel)
+    {
+        float* frames = stage.inputFrames.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(stage.jobInput.getWritePointer(channel), frames, 2 * size);
+        juce::FloatVectorOperations::copy(frames, frames + size, size);
+    }
+
+    worker->post(*stage.job);
+}
+
+void PartitionedConvolver::processDeferredFrame(Stage& stage)
+{
+    // The stage starts at least two partitions in, so the frame after next
+    // doesn't need the input that has only just come in
+    transformInput(stage, stage.jobInput);
+    computeOutput(stage, 1, stage.nextOutputFrames);
+}
+
+void PartitionedConvolver::transformInput(Stage& stage, juce::AudioBuffer<float>& frames)
+{
+    const int size = stage.layout.partitionSize;
+    const int spectrumSize = 2 * stage.numBins;
+    float* work = stage.work.data();
+
+    stage.fdlPosition = (stage.fdlPosition + 1) % stage.fdlLength;
+    for (int channel = 0; channel < numInputs; ++channel)
+    {
+        juce::FloatVectorOperations::copy(work, frames.getReadPointer(channel), 2 * size);
+        stage.fft->performRealOnlyForwardTransform(work, true);
+        juce::FloatVectorOperations::copy(stage.spectra.getWritePointer(channel, stage.fdlPosition * spectrumSize), work, spectrumSize);
+    }
+}
+
+void PartitionedConvolver::computeOutput(Stage& stage, int lead, juce::AudioBuffer<float>& destination)
+{
+    const int size = stage.layout.partitionSize;
+    const int spectrumSize = 2 * stage.numBins;
+    float* work = stage.work.data();
+
+    // The stage starts offset / size partitions into the IR, so its first
+    // partition meets the input spectrum from that many frames ago, minus the
+    // one frame of latency the stage's own buffering already adds, minus any
+    // frames this output is being computed ahead of time
+    const int firstDelay = stage.layout.offset / size - 1 - lead;
+    jassert(firstDelay >= 0);
+
+    for (int out = 0; out < numOutputs; ++out)
+    {
+        std::fill(work, work + 4 * size, 0.0f);
+
+        for (const auto& path : paths)
+        {
+            if (path.output != out)
+                continue;
+
+            const float* spectra = stage.spectra.getReadPointer(path.input);
+            const float* filters = stage.filters + path.irChannel * stage.layout.numPartitions * spectrumSize;
+
+            for (int partition = 0; partition < stage.layout.numPartitions; ++partition)
+            {
+                const int slot = (stage.fdlPosition - firstDelay - partition + 2 * stage.fdlLength) % stage.fdlLength;
+                const float* x = spectra + slot * spectrumSize;
+                const float* h = filters + partition * spectrumSize;
+
+                for (int bin = 0; bin < spectrumSize; bin += 2)
+                {
+                    work[bin]     += x[bin] * h[bin]     - x[bin + 1] * h[bin + 1];
+                    work[bin + 1] += x[bin] * h[bin + 1] + x[bin + 1] * h[bin];
+                }
+            }
+        }
+
+        // Overlap-save: the second half of the inverse transform is the
+        // output for the frame
+        stage.fft->performRealOnlyInverseTransform(work);
+        juce::FloatVectorOperations::copy(destination.getWritePointer(out), work + size, size);
+    }
+}
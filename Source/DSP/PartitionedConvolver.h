@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.h
+    Created: 17 Oct 2026 3:10:27pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TailWorker.h"
+
+// How an impulse response is split up: a short direct-form head, then FFT
+// stages whose partitions grow by growthRatio up to a size set by the IR
+// length. A stage with partition size P starts at an IR offset of at least P,
+// so its output is ready one frame after its input and the whole engine has
+// zero latency.
+//
+// With a lead frame, every stage at least twice the host block size starts at
+// an offset of at least two partitions, so its output for the next frame can
+// be computed a whole frame before it is heard (see TailWorker).
+struct PartitionScheme
+{
+    struct Stage
+    {
+        int partitionSize = 0;
+        int offset = 0;         // first IR sample this stage covers
+        int numPartitions = 0;
+    };
+
+    int headLength = 0;
+    std::vector<Stage> stages;
+
+    static constexpr int minHeadLength = 32;
+    static constexpr int maxHeadLength = 128;
+    static constexpr int maxPartitionSize = 16384;
+    static constexpr int growthRatio = 4;
+
+    // The head is sized from the host block size, the largest partition
+    // from the IR length
+    static PartitionScheme create(int maxBlockSize, int irLength, bool withLeadFrame = false);
+
+    // Whether a stage can be run a frame ahead
+    static bool canDefer(const Stage& stage, int maxBlockSize)
+    {
+        return stage.offset >= 2 * stage.partitionSize && stage.partitionSize >= 2 * maxBlockSize;
+    }
+};
+
+// An impulse response already split up and transformed: the head taps and
+// the partition spectra of every stage. It never changes once built, so it
+// can be shared between engines. Its data lives in storage.
+struct PartitionedIR
+{
+    PartitionScheme scheme;
+    int irLength = 0;
+    int numIRChannels = 0;
+
+    const float* headTaps = nullptr;            // per IR channel: headLength taps
+    std::vector<const float*> stageFilters;     // per stage, per IR channel: numPartitions spectra
+
+    std::vector<float> storage;
+
+    // Sizes in floats
+    size_t getHeadSize() const;
+    size_t getStageSize(size_t stage) const;
+
+    // Complex bins per spectrum are partitionSize + 1, interleaved
+    static int getSpectrumSize(int partitionSize) { return 2 * (partitionSize + 1); }
+
+    // IR channels an engine with numChannels inputs uses: four for true
+    // stereo, otherwise one or two
+    static int getNumIRChannels(int numFileChannels, int numChannels);
+
+    // Partitions and transforms the IR; allocates and runs FFTs
+    static std::shared_ptr<const PartitionedIR> transform(const juce::AudioBuffer<float>& ir, int maxBlockSize, int numChannels,
+                                                          bool withLeadFrame = false);
+};
+
+// Builds a PartitionedIR from an IR fed in order, a chunk at a time, so the
+// time-domain IR never has to be held alongside its spectra. Each partition
+// is transformed as soon as its last sample arrives.
+class PartitionedIRBuilder
+{
+public:
+    PartitionedIRBuilder(int irLength, int numIRChannels, int maxBlockSize, bool withLeadFrame = false);
+
+    // channels holds numIRChannels pointers
+    void append(const float* const* channels, int numSamples);
+
+    // Transforms what is left and applies gain to the whole IR, which is how
+    // a normalisation only known once every sample has been seen gets in
+    std::shared_ptr<const PartitionedIR> finish(float gain = 1.0f);
+
+private:
+    void transformPartition();
+
+    std::shared_ptr<PartitionedIR> partitions;
+    std::vector<float*> stageData;
+    int position = 0;
+
+    size_t stage = 0;
+    int partition = 0, framePosition = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    juce::AudioBuffer<float> frames;    // per IR channel: the partition being filled
+    std::vector<float> work;
+
+    JUCE_DECLARE_NON_COPYABLE(PartitionedIRBuilder)
+};
+
+// Zero-latency, non-uniformly partitioned overlap-save convolution. Building
+// one allocates (and transforming the IR takes a while), so do it off the
+// audio thread; process() itself never allocates.
+//
+// A mono IR is run on every channel, a stereo IR channel for channel. A
+// four-channel IR on a stereo bus runs true stereo, with the channels taken
+// as L->L, L->R, R->L, R->R. Each input is transformed once per frame and the
+// spectrum is shared by both of its output paths, so true stereo adds
+// multiply-adds but no FFTs over plain stereo.
+//
+// Given a TailWorker, the stages that can run a frame ahead (see
+// PartitionScheme::canDefer) have their FFTs and multiply-adds done on the
+// worker; the audio thread only moves samples in and out of them.
+class PartitionedConvolver
+{
+public:
+    PartitionedConvolver(const juce::AudioBuffer<float>& ir, int maxBlockSize, int numChannels);
+    PartitionedConvolver(std::shared_ptr<const PartitionedIR> partitions, int maxBlockSize, int numChannels,
+                         TailWorker* worker = nullptr);
+
+    // Waits for any frame still on the worker
+    ~PartitionedConvolver();
+
+    void reset();
+
+    // Replaces the block with the wet signal
+    void process(juce::dsp::AudioBlock<float>& block);
+
+    int getIRLength() const { return partitions->irLength; }
+    bool isTrueStereo() const { return paths.size() == 4; }
+    const PartitionScheme& getScheme() const { return partitions->scheme; }
+    const PartitionedIR& getPartitions() const { return *partitions; }
+
+private:
+    // One input channel convolved with one IR channel into one output channel
+    struct Path
+    {
+        int input, output, irChannel;
+    };
+
+    struct FrameJob;
+
+    struct Stage
+    {
+        PartitionScheme::Stage layout;
+        int numBins = 0;        // partitionSize + 1 complex bins
+        int fdlLength = 0;      // input spectra kept, including the delay to the stage offset
+        int fdlPosition = 0;    // slot holding the newest input spectrum
+        int framePosition = 0;  // samples into the current frame
+
+        std::unique_ptr<juce::dsp::FFT> fft;
+        juce::AudioBuffer<float> inputFrames;   // per input: previous and current frame
+        juce::AudioBuffer<float> spectra;       // per input: frequency-domain delay line
+        juce::AudioBuffer<float> outputFrames;  // per output: the frame being played
+        const float* filters = nullptr;         // per IR channel: numPartitions spectra
+        std::vector<float> work;                // FFT buffer, 4 * partitionSize
+
+        // Deferred stages only. The job transforms jobInput and computes the
+        // frame after the one being played into nextOutputFrames.
+        std::unique_ptr<FrameJob> job;
+        juce::AudioBuffer<float> jobInput;          // per input: copy of inputFrames
+        juce::AudioBuffer<float> nextOutputFrames;  // per output
+    };
+
+    struct FrameJob : TailWorker::Job
+    {
+        FrameJob(PartitionedConvolver& o, Stage& s) : owner(o), stage(s) {}
+        void run() override { owner.processDeferredFrame(stage); }
+
+        PartitionedConvolver& owner;
+        Stage& stage;
+    };
+
+    void processHead(int numSamples);
+    void processStage(Stage& stage, int numSamples);
+    void processFrame(Stage& stage);
+
+    // Audio thread: collects the frame the worker computed and posts the next
+    void startDeferredFrame(Stage& stage);
+    void processDeferredFrame(Stage& stage);
+
+    // Moves the newest two frames of input into the delay line
+    void transformInput(Stage& stage, juce::AudioBuffer<float>& frames);
+
+    // Fills destination with the output for lead frames after the next one
+    void computeOutput(Stage& stage, int lead, juce::AudioBuffer<float>& destination);
+
+    std::shared_ptr<const PartitionedIR> partitions;
+    int headLength = 0, maxBlockSize = 0;
+    int numInputs = 0, numOutputs = 0;
+    std::vector<Path> paths;
+
+    juce::AudioBuffer<float> headHistory;   // per input: headLength - 1 old samples, then the block
+    juce::AudioBuffer<float> output;
+    std::vector<Stage> stages;
+    TailWorker* worker = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver)
+};
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    AutoCorrelationDetector.cpp
+    Created: 18 Oct 2026 11:20:36am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "AutoCorrelationDetector.h"
+
+AutoCorrelationDetector::AutoCorrelationDetector(int functionToUse)
+    : autoCorrelation(std::make_unique<AutoCorrelation>()),
+      function(functionToUse)
+{
+    jassert(function == AutoCorrelation::fftFunction || function == AutoCorrelation::slidingFunction);
+}
+
+void AutoCorrelationDetector::prepare(double sampleRate, int windowSize, int newHopSize)
+{
+    frameSize = juce::jmin(8192, juce::nextPowerOfTwo(2 * windowSize));
+    hopSize = juce::jlimit(1, frameSize, newHopSize);
+
+    autoCorrelation->function = function;
+    autoCorrelation->windowSizePower2 = juce::roundToInt(std::log2(frameSize));
+    autoCorrelation->hoppingSize = hopSize;
+    autoCorrelation->lowestFrequency = static_cast<float> (minFrequency);
+    autoCorrelation->prepare(sampleRate, hopSize);
+
+    reset();
+}
+
+void AutoCorrelationDetector::reset()
+{
+    autoCorrelation->reset();
+    hopFill = 0;
+    samplesPushed = 0;
+    estimate = {};
+}
+
+void AutoCorrelationDetector::pushSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        const int count = juce::jmin(numSamples, hopSize - hopFill);
+        autoCorrelation->pushSamples(samples, count);
+        hopFill += count;
+        samplesPushed += count;
+        samples += count;
+        numSamples -= count;
+
+        if (hopFill < hopSize)
+            continue;
+
+        hopFill = 0;
+        double frequency = function == AutoCorrelation::slidingFunction ? autoCorrelation->getFrequencySliding()
+                                                                         : autoCorrelation->getFrequencyFFT();
+        if (frequency < minFrequency || frequency > maxFrequency)
+            frequency = -1.0;
+
+        estimate = { frequency, frequency > 0 ? autoCorrelation->getClarity() : 0.0, samplesPushed };
+    }
+}
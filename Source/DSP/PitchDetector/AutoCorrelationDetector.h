@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    AutoCorrelationDetector.h
+    Created: 18 Oct 2026 11:20:36am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "autoCorrelation.h"
+#include "PitchDetector.h"
+
+// AutoCorrelation's second-peak picker behind the PitchDetector interface.
+// It has no decimation and no tracking, so it is cheap and reacts within a
+// frame, but it is easily thrown an octave by breathy or formant-heavy
+// input; it suits clean sources such as a bass DI. The confidence is the
+// peak's clarity.
+class AutoCorrelationDetector : public PitchDetector
+{
+public:
+    // fftFunction or slidingFunction: the two give the same correlation, but
+    // the sliding one is cheaper when hops are short
+    explicit AutoCorrelationDetector(int functionToUse);
+
+    // The frame is rounded up to a power of two, at most 8192 samples
+    void prepare(double sampleRate, int windowSize, int hopSize) override;
+    void reset() override;
+    void pushSamples(const float* samples, int numSamples) override;
+    PitchEstimate getEstimate() const override { return estimate; }
+    int getLatencyInSamples() const override { return frameSize / 2; }
+
+private:
+    // Big arrays inside, so it lives on the heap
+    std::unique_ptr<AutoCorrelation> autoCorrelation;
+    int function;
+    int frameSize = 1024;
+    int hopSize = 512;
+    int hopFill = 0;
+    juce::int64 samplesPushed = 0;
+
+    PitchEstimate estimate;
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    Decimator.cpp
+    Created: 18 Oct 2026 1:12:08am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "Decimator.h"
+
+void Decimator::prepare(int newFactor, double sampleRate, double passbandHz)
+{
+    factor = juce::jmax(1, newFactor);
+
+    if (factor == 1)
+    {
+        numTaps = 1;
+        coefficients.assign(1, 1.0f);
+    }
+    else
+    {
+        // A Blackman window's transition band is about 5.5 / numTaps wide
+        const double stopbandHz = sampleRate / (2.0 * factor);
+        jassert(passbandHz < stopbandHz);
+        const double transition = juce::jmax(stopbandHz - passbandHz, stopbandHz * 0.1) / sampleRate;
+        numTaps = static_cast<int> (std::ceil(5.5 / transition)) | 1;
+
+        const double cutoff = 0.5 * (passbandHz + stopbandHz) / sampleRate;
+        const double centre = 0.5 * (numTaps - 1);
+        coefficients.resize(static_cast<size_t> (numTaps));
+
+        double sum = 0.0;
+        for (int i = 0; i < numTaps; ++i)
+        {
+            const double t = i - centre;
+            const double sinc = t == 0.0 ? 2.0 * cutoff
+                                         : std::sin(juce::MathConstants<double>::twoPi * cutoff * t) / (juce::MathConstants<double>::pi * t);
+            const double x = juce::MathConstants<double>::twoPi * i / (numTaps - 1);
+            const double window = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+            coefficients[static_cast<size_t> (i)] = static_cast<float> (sinc * window);
+            sum += sinc * window;
+        }
+
+        // Unity gain at DC
+        for (auto& c : coefficients)
+            c = static_cast<float> (c / sum);
+    }
+
+    history.assign(2 * static_cast<size_t> (numTaps), 0.0f);
+    reset();
+}
+
+void Decimator::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    writeIndex = 0;
+    phase = 0;
+}
+
+int Decimator::process(const float* input, int numSamples, float* output)
+{
+    if (factor == 1)
+    {
+        juce::FloatVectorOperations::copy(output, input, numSamples);
+        return numSamples;
+    }
+
+    int numOutputs = 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        history[static_cast<size_t> (writeIndex)] = input[i];
+        history[static_cast<size_t> (writeIndex + numTaps)] = input[i];
+        writeIndex = (writeIndex + 1) % numTaps;
+
+        if (++phase < factor)
+            continue;
+        phase = 0;
+
+        // Oldest to newest; the filter is symmetric, so no need to reverse it
+        const float* window = history.data() + writeIndex;
+        float sum = 0.0f;
+        for (int k = 0; k < numTaps; ++k)
+            sum += coefficients[static_cast<size_t> (k)] * window[k];
+
+        output[numOutputs++] = sum;
+    }
+
+    return numOutputs;
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    Decimator.h
+    Created: 18 Oct 2026 1:12:08am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Low-pass filters a signal and keeps every factor-th sample, so pitch
+// analysis can run at a fraction of the host rate. The filter is a
+// Blackman-windowed sinc evaluated polyphase: only the kept outputs are
+// computed, so each input sample costs numTaps / factor multiplies.
+class Decimator
+{
+public:
+    // Allocates. Everything up to passbandHz is kept and everything from the
+    // decimated Nyquist up is rejected by about 70 dB. A factor of 1 passes
+    // the input straight through.
+    void prepare(int factor, double sampleRate, double passbandHz);
+    void reset();
+
+    // Writes one output for every factor inputs, carrying the remainder over
+    // to the next call, and returns how many were written
+    int process(const float* input, int numSamples, float* output);
+
+    int getFactor() const { return factor; }
+
+    // Group delay at the input rate
+    int getLatencyInSamples() const { return (numTaps - 1) / 2; }
+
+private:
+    int factor = 1;
+    int numTaps = 1;
+    int phase = 0;          // inputs since the last output
+    int writeIndex = 0;
+
+    std::vector<float> coefficients;
+    std::vector<float> history; // two copies, so the last numTaps inputs are contiguous
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Decimator)
+};
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    MpmDetector.cpp
+    Created: 18 Oct 2026 2:37:52pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "MpmDetector.h"
+
+void MpmDetector::prepare(double newSampleRate, int newWindowSize, int newHopSize)
+{
+    sampleRate = newSampleRate;
+    windowSize = juce::jmax(4, newWindowSize);
+    hopSize = juce::jlimit(1, windowSize, newHopSize);
+
+    // Lags up to the window, so the zero padding has to cover it
+    const int frameSize = 2 * windowSize;
+    const int order = juce::roundToInt(std::ceil(std::log2(frameSize + windowSize)));
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    fftData.assign(2 * static_cast<size_t> (fft->getSize()), 0.0f);
+
+    frame.assign(static_cast<size_t> (frameSize), 0.0f);
+    energy.assign(static_cast<size_t> (frameSize) + 1, 0.0);
+    nsdf.assign(static_cast<size_t> (windowSize), 0.0);
+    keyMaxima.reserve(static_cast<size_t> (windowSize));
+
+    reset();
+}
+
+void MpmDetector::reset()
+{
+    std::fill(frame.begin(), frame.end(), 0.0f);
+    hopFill = 0;
+    samplesPushed = 0;
+    estimate = {};
+}
+
+void MpmDetector::pushSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        // The frame slides along; the newest hop fills in at the end
+        const int count = juce::jmin(numSamples, hopSize - hopFill);
+        const auto start = frame.size() - static_cast<size_t> (hopSize) + static_cast<size_t> (hopFill);
+        juce::FloatVectorOperations::copy(frame.data() + start, samples, count);
+        hopFill += count;
+        samplesPushed += count;
+        samples += count;
+        numSamples -= count;
+
+        if (hopFill < hopSize)
+            continue;
+
+        analyseFrame();
+
+        std::memmove(frame.data(), frame.data() + hopSize, sizeof(float) * (frame.size() - static_cast<size_t> (hopSize)));
+        hopFill = 0;
+    }
+}
+
+void MpmDetector::computeNsdf()
+{
+    const size_t frameSize = frame.size();
+
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    std::copy(frame.begin(), frame.end(), fftData.begin());
+
+    // r(tau) is the inverse FFT of the power spectrum; the inverse is
+    // scaled by 1 / N, so it comes out as the plain sum
+    fft->performRealOnlyForwardTransform(fftData.data(), true);
+    for (int bin = 0; bin <= fft->getSize() / 2; ++bin)
+    {
+        auto& re = fftData[2 * static_cast<size_t> (bin)];
+        auto& im = fftData[2 * static_cast<size_t> (bin) + 1];
+        re = re * re + im * im;
+        im = 0.0f;
+    }
+    fft->performRealOnlyInverseTransform(fftData.data());
+
+    // m(tau) = e(0, N - tau) + e(tau, N)
+    for (size_t tau = 0; tau < nsdf.size(); ++tau)
+    {
+        const double m = energy[frameSize - tau] + energy[frameSize] - energy[tau];
+        nsdf[tau] = m > 0.0 ? 2.0 * fftData[tau] / m : 0.0;
+    }
+}
+
+void MpmDetector::analyseFrame()
+{
+    for (size_t i = 0; i < frame.size(); ++i)
+        energy[i + 1] = energy[i] + static_cast<double> (frame[i]) * frame[i];
+
+    estimate = { -1.0, 0.0, samplesPushed };
+    if (energy.back() < silenceEnergy * static_cast<double> (frame.size()))
+        return;
+
+    computeNsdf();
+
+    // One key maximum per positive lobe, skipping the one around lag 0
+    const auto minLag = static_cast<size_t> (std::floor(sampleRate / maxFrequency));
+    keyMaxima.clear();
+    size_t tau = 1;
+    while (tau < nsdf.size() && nsdf[tau] > 0.0)
+        ++tau;
+
+    size_t best = 0;
+    for (; tau < nsdf.size(); ++tau)
+    {
+        if (nsdf[tau] > 0.0 && (best == 0 || nsdf[tau] > nsdf[best]))
+            best = tau;
+
+        const bool lobeEnds = nsdf[tau] <= 0.0 || tau + 1 == nsdf.size();
+        if (lobeEnds && best != 0)
+        {
+            if (best >= minLag)
+                keyMaxima.push_back(best);
+            best = 0;
+        }
+    }
+
+    if (keyMaxima.empty())
+        return;
+
+    double highest = 0.0;
+    for (const auto key : keyMaxima)
+        highest = juce::jmax(highest, nsdf[key]);
+
+    for (const auto key : keyMaxima)
+    {
+        if (nsdf[key] < clarityRatio * highest)
+            continue;
+
+        const auto [period, clarity] = Yin::parabolic_interpolation(nsdf, key);
+        const double frequency = sampleRate / period;
+        estimate.voicedProbability = juce::jlimit(0.0, 1.0, clarity);
+        if (clarity >= minClarity && frequency >= minFrequency && frequency <= maxFrequency)
+            estimate.frequency = frequency;
+        return;
+    }
+}
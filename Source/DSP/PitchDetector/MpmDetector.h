@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    MpmDetector.h
+    Created: 18 Oct 2026 2:37:52pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchDetector.h"
+#include "Yin.h"
+
+// The McLeod Pitch Method. The normalised square difference
+//
+//     n(tau) = 2 r(tau) / m(tau),  m(tau) = sum (x[j]^2 + x[j + tau]^2)
+//
+// over the frame's overlapping pairs lies between -1 and 1 whatever the
+// level or the lag, so it needs no threshold tuning and copes with frames
+// only a couple of periods long. r comes from one FFT and m from a prefix
+// sum of the frame's energy.
+//
+// The peak between each upward and downward zero crossing of n is a key
+// maximum; the first within clarityRatio of the highest gives the period.
+// Its height, the clarity, is the confidence. There is no tracking, so
+// estimates lag the input by only half a frame.
+class MpmDetector : public PitchDetector
+{
+public:
+    void prepare(double sampleRate, int windowSize, int hopSize) override;
+    void reset() override;
+    void pushSamples(const float* samples, int numSamples) override;
+    PitchEstimate getEstimate() const override { return estimate; }
+    int getLatencyInSamples() const override { return windowSize; }
+
+    // Key maxima this close to the highest count as the period; lower picks
+    // more octave-down errors, higher more octave-up
+    static constexpr double clarityRatio = 0.9;
+
+    // Below this the period is too weak to call it a pitch (noise peaks at
+    // around 0.3)
+    static constexpr double minClarity = 0.5;
+
+    // Frames quieter than this, in mean square, are unpitched (-60 dB)
+    static constexpr double silenceEnergy = 1e-6;
+
+private:
+    // Estimates the pitch of the frame ending with the hop just filled
+    void analyseFrame();
+
+    // nsdf[tau] for every lag up to the window
+    void computeNsdf();
+
+    double sampleRate = 48000.0;
+    int windowSize = 512;
+    int hopSize = 512;
+
+    std::vector<float> frame;       // 2 * windowSize, oldest first
+    int hopFill = 0;
+    juce::int64 samplesPushed = 0;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData;
+    std::vector<double> energy;     // energy[k] = sum of frame[i]^2 for i < k
+    std::vector<double> nsdf;
+    std::vector<size_t> keyMaxima;  // reserved in prepare
+
+    PitchEstimate estimate;
+};
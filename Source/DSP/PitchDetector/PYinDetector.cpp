@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    PYinDetector.cpp
+    Created: 18 Oct 2026 10:52:03am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "PYinDetector.h"
+
+void PYinDetector::prepare(double newSampleRate, int newWindowSize, int newHopSize)
+{
+    sampleRate = newSampleRate;
+
+    int factor = 1;
+    while (factor < maxDecimation && sampleRate / (2 * factor) >= analysisRate)
+        factor *= 2;
+
+    windowSize = juce::jmax(factor * 4, newWindowSize / factor * factor);
+    hopSize = juce::jlimit(1, windowSize, newHopSize);
+    hopSize = (hopSize + factor - 1) / factor * factor;
+
+    decimator.prepare(factor, sampleRate, PYIN_MAX_FREQUENCY);
+
+    juce::dsp::ProcessSpec spec{ sampleRate / factor, static_cast<juce::uint32> (windowSize / factor), 1 };
+    yin.prepare(spec);
+    yin.SetHopSize(static_cast<size_t> (hopSize / factor));
+
+    hop.assign(static_cast<size_t> (hopSize), 0.0f);
+    decimatedHop.assign(static_cast<size_t> (hopSize / factor), 0.0f);
+    frame.assign(yin.GetFrameSize(), 0.0f);
+    history.assign(static_cast<size_t> (2 * windowSize + decimator.getLatencyInSamples())
+                       + yin.GetLookback() * static_cast<size_t> (hopSize), 0.0f);
+
+    reset();
+}
+
+void PYinDetector::reset()
+{
+    yin.Reset();
+    decimator.reset();
+    std::fill(frame.begin(), frame.end(), 0.0f);
+    std::fill(history.begin(), history.end(), 0.0f);
+    hopFill = 0;
+    samplesAnalysed = 0;
+    estimate = {};
+}
+
+void PYinDetector::pushSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        const int count = juce::jmin(numSamples, hopSize - hopFill);
+        juce::FloatVectorOperations::copy(hop.data() + hopFill, samples, count);
+        hopFill += count;
+        samples += count;
+        numSamples -= count;
+
+        if (hopFill == hopSize)
+        {
+            analyseHop();
+            hopFill = 0;
+        }
+    }
+}
+
+int PYinDetector::getLatencyInSamples() const
+{
+    // The middle of the frame, the Viterbi's lookback and the filter's delay
+    return windowSize + static_cast<int> (yin.GetLookback()) * hopSize + decimator.getLatencyInSamples();
+}
+
+void PYinDetector::analyseHop()
+{
+    // Both frames slide along by a hop; the oldest samples fall off the front
+    const auto slide = [](std::vector<float>& buffer, const float* samples, int numSamples)
+    {
+        const auto keep = buffer.size() - static_cast<size_t> (numSamples);
+        std::memmove(buffer.data(), buffer.data() + numSamples, sizeof(float) * keep);
+        juce::FloatVectorOperations::copy(buffer.data() + keep, samples, numSamples);
+    };
+
+    slide(history, hop.data(), hopSize);
+    slide(frame, decimatedHop.data(), decimator.process(hop.data(), hopSize, decimatedHop.data()));
+    samplesAnalysed += hopSize;
+
+    double frequency = yin.Pitch(frame.data());
+    const size_t delayFrames = yin.GetDecodeDelay();
+    if (frequency > 0 && decimator.getFactor() > 1)
+        frequency = refine(frequency, delayFrames);
+
+    // The Viterbi settles a few frames behind the newest one, and the
+    // decimated frame lags the input by the filter's delay
+    const auto delay = static_cast<juce::int64> (delayFrames) * hopSize + decimator.getLatencyInSamples();
+    estimate = { frequency, yin.GetVoicedProbability(), samplesAnalysed - delay };
+}
+
+double PYinDetector::refine(double coarseFrequency, size_t delayFrames) const
+{
+    // The full-rate frame lined up with the decimated one pYIN decoded
+    const size_t offset = history.size() - static_cast<size_t> (2 * windowSize + decimator.getLatencyInSamples())
+                        - delayFrames * static_cast<size_t> (hopSize);
+    const float* x = history.data() + offset;
+
+    const auto difference = [x, this](int tau)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < windowSize; ++j)
+        {
+            const double d = x[j] - x[j + tau];
+            sum += d * d;
+        }
+        return sum;
+    };
+
+    const int factor = decimator.getFactor();
+    const int centre = juce::roundToInt(sampleRate / coarseFrequency);
+    const int first = juce::jmax(2, centre - factor);
+    const int last = juce::jmin(windowSize - 2, centre + factor);
+    if (first > last)
+        return coarseFrequency;
+
+    int bestTau = first;
+    double best = std::numeric_limits<double>::max();
+    for (int tau = first; tau <= last; ++tau)
+    {
+        const double d = difference(tau);
+        if (d < best)
+        {
+            best = d;
+            bestTau = tau;
+        }
+    }
+
+    // Parabolic interpolation between the neighbours
+    const double before = difference(bestTau - 1);
+    const double after = difference(bestTau + 1);
+    const double den = before + after - 2.0 * best;
+    const double tau = den > 0.0 ? bestTau + 0.5 * (before - after) / den : bestTau;
+
+    return sampleRate / tau;
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    PYinDetector.h
+    Created: 18 Oct 2026 10:52:03am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Decimator.h"
+#include "PitchDetector.h"
+#include "Yin.h"
+
+// pYIN with its Viterbi tracker. Nothing VocalBox tracks lies above
+// PYIN_MAX_FREQUENCY, so pYIN runs on a copy decimated to around
+// analysisRate. The decoded lag is then refined on the full-rate frame it
+// came from, which restores full-rate accuracy.
+class PYinDetector : public PitchDetector
+{
+public:
+    // windowSize is rounded down to a whole number of decimated samples and
+    // the hop up to one, at most windowSize
+    void prepare(double sampleRate, int windowSize, int hopSize) override;
+    void reset() override;
+    void pushSamples(const float* samples, int numSamples) override;
+    PitchEstimate getEstimate() const override { return estimate; }
+    int getLatencyInSamples() const override;
+
+    // The lowest rate pYIN is decimated to
+    static constexpr double analysisRate = 11025.0;
+    static constexpr int maxDecimation = 8;
+
+private:
+    // Analyses the frame ending with the hop just filled
+    void analyseHop();
+
+    // Searches the full-rate difference function a decimated lag either side
+    // of the coarse estimate, delayFrames hops back
+    double refine(double coarseFrequency, size_t delayFrames) const;
+
+    Yin::Yin_Pitch yin;
+    Decimator decimator;
+    double sampleRate = 48000.0;
+    int windowSize = 512;
+    int hopSize = 512;
+
+    std::vector<float> hop;
+    int hopFill = 0;
+    std::vector<float> decimatedHop;
+    std::vector<float> frame;       // decimated, as pYIN sees it
+    std::vector<float> history;     // full rate, reaching back past the decode delay
+    juce::int64 samplesAnalysed = 0;
+
+    PitchEstimate estimate;
+};
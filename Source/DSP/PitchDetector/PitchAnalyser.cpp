@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    PitchAnalyser.cpp
+    Created: 17 Oct 2026 11:02:45pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "PitchAnalyser.h"
+
+PitchAnalyser::PitchAnalyser()
+    : juce::Thread("Pitch Analysis")
+{
+}
+
+PitchAnalyser::~PitchAnalyser()
+{
+    stopThread(4000);
+}
+
+void PitchAnalyser::prepare(double newSampleRate, int windowSize, int newHopSize, bool runOnCallingThread)
+{
+    stopThread(4000);
+
+    sampleRate = newSampleRate;
+    hopSize = juce::jlimit(1, windowSize, newHopSize);
+    isSynchronous = runOnCallingThread;
+
+    for (auto* detector : detectors)
+        detector->prepare(sampleRate, windowSize, hopSize);
+
+    hop.assign(static_cast<size_t> (hopSize), 0.0f);
+    fifoData.assign(static_cast<size_t> (fifoHops * hopSize), 0.0f);
+    fifo = std::make_unique<juce::AbstractFifo>(static_cast<int> (fifoData.size()));
+
+    algorithm = requestedAlgorithm.load();
+    samplesAnalysed = 0;
+    detectorStart = 0;
+    samplesPushed = 0;
+    samplesDropped = 0;
+    droppedSoFar = 0;
+    publish({});
+
+    if (! isSynchronous)
+        startThread();
+}
+
+void PitchAnalyser::setAlgorithm(int newAlgorithm)
+{
+    requestedAlgorithm.store(juce::jlimit(0, numAlgorithms - 1, newAlgorithm));
+}
+
+int PitchAnalyser::getLatencyInSamples() const
+{
+    return detectors[static_cast<size_t> (requestedAlgorithm.load())]->getLatencyInSamples();
+}
+
+void PitchAnalyser::pushSamples(const float* samples, int numSamples)
+{
+    if (! isSynchronous)
+    {
+        writeToFifo(samples, numSamples);
+        return;
+    }
+
+    // Analysing as it goes keeps room in the FIFO, so nothing is dropped
+    while (numSamples > 0)
+    {
+        const int written = writeToFifo(samples, numSamples);
+        samples += written;
+        numSamples -= written;
+
+        while (fifo->getNumReady() >= hopSize)
+            analyseHop();
+    }
+}
+
+int PitchAnalyser::writeToFifo(const float* samples, int numSamples)
+{
+    const auto scope = fifo->write(numSamples);
+    if (scope.blockSize1 > 0)
+        juce::FloatVectorOperations::copy(fifoData.data() + scope.startIndex1, samples, scope.blockSize1);
+    if (scope.blockSize2 > 0)
+        juce::FloatVectorOperations::copy(fifoData.data() + scope.startIndex2, samples + scope.blockSize1, scope.blockSize2);
+
+    // The clock counts what was dropped as well, so it stays in step with
+    // the caller's; analyseHop moves the estimates' positions on to match
+    const int written = scope.blockSize1 + scope.blockSize2;
+    if (written < numSamples && ! isSynchronous)
+        samplesDropped += numSamples - written;
+
+    samplesPushed += isSynchronous ? written : numSamples;
+    return written;
+}
+
+void PitchAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        if (fifo->getNumReady() >= hopSize)
+            analyseHop();
+        else
+            wait(pollIntervalMs);
+    }
+}
+
+void PitchAnalyser::analyseHop()
+{
+    {
+        const auto scope = fifo->read(hopSize);
+        juce::FloatVectorOperations::copy(hop.data(), fifoData.data() + scope.startIndex1, scope.blockSize1);
+        if (scope.blockSize2 > 0)
+            juce::FloatVectorOperations::copy(hop.data() + scope.blockSize1, fifoData.data() + scope.startIndex2, scope.blockSize2);
+    }
+
+    // Samples dropped since the last hop are counted in here, up to a FIFO's
+    // length before the gap actually comes through; the positions never
+    // drift, whatever is dropped
+    const auto dropped = samplesDropped.load();
+    samplesAnalysed += dropped - droppedSoFar;
+    detectorStart += dropped - droppedSoFar;
+    droppedSoFar = dropped;
+
+    // The others were prepared with this one, so switching doesn't allocate
+    const int wanted = requestedAlgorithm.load();
+    if (wanted != algorithm)
+    {
+        algorithm = wanted;
+        detectors[static_cast<size_t> (algorithm)]->reset();
+        detectorStart = samplesAnalysed;
+    }
+
+    auto& detector = *detectors[static_cast<size_t> (algorithm)];
+    detector.pushSamples(hop.data(), hopSize);
+    samplesAnalysed += hopSize;
+
+    auto estimate = detector.getEstimate();
+    estimate.samplePosition += detectorStart;
+    publish(estimate);
+}
+
+void PitchAnalyser::publish(const PitchEstimate& estimate)
+{
+    // Written into the slot readers aren't directed to. The fence orders
+    // these writes after the previous publish, so a reader that sees any of
+    // them also sees that publish's count.
+    const auto next = sequence.load(std::memory_order_relaxed) + 1;
+    auto& slot = slots[next & 1];
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.frequency.store(estimate.frequency, std::memory_order_relaxed);
+    slot.voicing.store(estimate.voicedProbability, std::memory_order_relaxed);
+    slot.position.store(estimate.samplePosition, std::memory_order_relaxed);
+
+    sequence.store(next, std::memory_order_release);
+}
+
+PitchEstimate PitchAnalyser::getEstimate() const
+{
+    // A retry needs a whole publish to land during the read, and publishes
+    // are a hop apart, so a second attempt practically always succeeds
+    for (int attempt = 0; attempt < maxReadAttempts; ++attempt)
+    {
+        const auto before = sequence.load(std::memory_order_acquire);
+        const auto& slot = slots[before & 1];
+
+        PitchEstimate estimate;
+        estimate.frequency = slot.frequency.load(std::memory_order_relaxed);
+        estimate.voicedProbability = slot.voicing.load(std::memory_order_relaxed);
+        estimate.samplePosition = slot.position.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+            return estimate;
+    }
+
+    // No pitch rather than a torn one
+    return {};
+}
+
+PitchEstimate PitchAnalyser::getCurrentEstimate() const
+{
+    auto estimate = getEstimate();
+    const auto age = samplesPushed.load(std::memory_order_relaxed) - estimate.samplePosition;
+    if (age > static_cast<juce::int64> (maxAgeSeconds * sampleRate))
+    {
+        estimate.frequency = -1.0;
+        estimate.voicedProbability = 0.0;
+    }
+    return estimate;
+}
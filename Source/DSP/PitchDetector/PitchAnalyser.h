@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    PitchAnalyser.h
+    Created: 17 Oct 2026 11:02:45pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AutoCorrelationDetector.h"
+#include "MpmDetector.h"
+#include "PitchDetector.h"
+#include "PYinDetector.h"
+
+// Runs a pitch detector on a background thread. The audio thread copies its
+// input into a single-producer, single-consumer FIFO and reads back the
+// latest estimate; neither takes a lock. Estimates are published into two
+// alternating slots, so any thread (the editor included) can read a
+// consistent one without ever waiting on the analysis thread.
+//
+// Every algorithm is prepared up front, so switching between them only
+// resets one. The new one reports no pitch until it has a frame of input.
+//
+// Offline, where the audio thread runs faster than real time, the analysis
+// runs on the calling thread instead so a bounce sees the same pitches every
+// time.
+class PitchAnalyser : private juce::Thread
+{
+public:
+    PitchAnalyser();
+    ~PitchAnalyser() override;
+
+    enum Algorithm
+    {
+        pyin = 0,
+        autoCorrelationFFT,
+        autoCorrelationSliding,
+        mpm,
+        numAlgorithms
+    };
+
+    // Allocates and restarts the thread. windowSize and hopSize are passed
+    // to every detector.
+    void prepare(double sampleRate, int windowSize, int hopSize, bool runOnCallingThread);
+
+    // Any thread. Takes effect from the next hop.
+    void setAlgorithm(int algorithm);
+
+    // Audio thread. If the analysis falls behind far enough to fill the FIFO,
+    // the newest samples are dropped. Positions still count them, so they
+    // match the number of samples pushed.
+    void pushSamples(const float* samples, int numSamples);
+
+    // Any thread
+    PitchEstimate getEstimate() const;
+
+    // Audio thread: the latest estimate, or no pitch once it is older than
+    // maxAgeSeconds (say, after the analysis thread stalls)
+    PitchEstimate getCurrentEstimate() const;
+
+    // Of the algorithm last asked for
+    int getLatencyInSamples() const;
+
+    static constexpr double maxAgeSeconds = 0.1;
+
+private:
+    void run() override;
+
+    // Returns how many samples fitted
+    int writeToFifo(const float* samples, int numSamples);
+
+    // Shifts in hopSize samples from the FIFO and runs the detector on them
+    void analyseHop();
+    void publish(const PitchEstimate& estimate);
+
+    PYinDetector pyinDetector;
+    AutoCorrelationDetector fftDetector{ AutoCorrelation::fftFunction };
+    AutoCorrelationDetector slidingDetector{ AutoCorrelation::slidingFunction };
+    MpmDetector mpmDetector;
+    const std::array<PitchDetector*, numAlgorithms> detectors{ &pyinDetector, &fftDetector, &slidingDetector, &mpmDetector };
+
+    std::atomic<int> requestedAlgorithm{ pyin };
+    double sampleRate = 48000.0;
+    int hopSize = 512;
+    bool isSynchronous = false;
+
+    std::unique_ptr<juce::AbstractFifo> fifo;
+    std::vector<float> fifoData;
+    // Analysis thread only
+    std::vector<float> hop;
+    int algorithm = pyin;
+    juce::int64 samplesAnalysed = 0;   // input position, drops included
+    juce::int64 detectorStart = 0;     // input position the detector's own count starts from
+    juce::int64 droppedSoFar = 0;      // samplesDropped already counted in
+
+    // Every sample given to pushSamples, whether or not it fitted
+    std::atomic<juce::int64> samplesPushed{ 0 };
+    std::atomic<juce::int64> samplesDropped{ 0 };
+
+    struct EstimateSlot
+    {
+        std::atomic<double> frequency{ -1.0 };
+        std::atomic<double> voicing{ 0.0 };
+        std::atomic<juce::int64> position{ 0 };
+    };
+
+    // Publishes so far; the latest estimate is in slots[sequence & 1] and
+    // the next is written into the other one
+    std::atomic<juce::uint32> sequence{ 0 };
+    std::array<EstimateSlot, 2> slots;
+    static constexpr int maxReadAttempts = 4;
+
+    static constexpr int fifoHops = 16;
+    static constexpr int pollIntervalMs = 5;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchAnalyser)
+};
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    PitchDetector.h
+    Created: 18 Oct 2026 10:41:17am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// A pitch estimate and the input sample it was made up to
+struct PitchEstimate
+{
+    double frequency = -1.0;        // Hz, or -1 for no pitch
+    double voicedProbability = 0.0; // 0 to 1
+    juce::int64 samplePosition = 0; // input samples since prepare
+};
+
+// What every pitch detector looks like from outside. Samples go in through
+// pushSamples in blocks of any size, and a new estimate is made every hop.
+// Nothing here is thread-safe: PitchAnalyser runs one detector at a time on
+// its thread and publishes the estimates.
+class PitchDetector
+{
+public:
+    virtual ~PitchDetector() = default;
+
+    // Allocates. windowSize is the integration window at sampleRate; each
+    // frame is twice that, and a new one starts every hopSize samples.
+    virtual void prepare(double sampleRate, int windowSize, int hopSize) = 0;
+
+    // Forgets the input so far without allocating, so a detector prepared
+    // up front can be switched to at any time
+    virtual void reset() = 0;
+
+    virtual void pushSamples(const float* samples, int numSamples) = 0;
+
+    // The newest estimate. Its samplePosition counts from the last reset.
+    virtual PitchEstimate getEstimate() const = 0;
+
+    // 0 to 1: how sure the detector is that the newest estimate is pitched
+    double getConfidence() const { return getEstimate().voicedProbability; }
+
+    // How far the middle of the audio an estimate describes lags the newest
+    // input when the estimate is made
+    virtual int getLatencyInSamples() const = 0;
+
+    // Estimates outside this range come out as no pitch; VocalBox acts on
+    // nothing above it
+    static constexpr double minFrequency = 20.0;
+    static constexpr double maxFrequency = 3000.0;
+};
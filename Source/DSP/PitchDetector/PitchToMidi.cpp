@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    PitchToMidi.cpp
+    Created: 18 Oct 2026 3:26:51am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "PitchToMidi.h"
+
+void PitchToMidi::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    const auto coefficient = [this](double seconds)
+    {
+        return static_cast<float> (1.0 - std::exp(-1.0 / (seconds * sampleRate)));
+    };
+
+    fastAttack = coefficient(0.0005);
+    fastRelease = coefficient(0.005);
+    slowCoefficient = coefficient(0.05);
+
+    settleSamples = static_cast<juce::int64> (settleSeconds * sampleRate);
+    refractorySamples = static_cast<juce::int64> (refractorySeconds * sampleRate);
+    pendingTimeoutSamples = static_cast<juce::int64> (pendingTimeoutSeconds * sampleRate);
+    maxAgeSamples = static_cast<juce::int64> (PitchAnalyser::maxAgeSeconds * sampleRate);
+
+    const int onsetWindow = juce::roundToInt(onsetWindowSeconds * sampleRate);
+    onsetDetector.prepare(sampleRate, onsetWindow, juce::jmax(1, onsetWindow / 4));
+
+    reset();
+}
+
+void PitchToMidi::reset()
+{
+    fastEnvelope = slowEnvelope = 0;
+    isJumpArmed = true;
+    state = State::idle;
+    position = 0;
+    onsetDetector.reset();
+    onsetDetectorStart = 0;
+    isOnsetDetectorStale = false;
+    lastOnset = -refractorySamples;
+    lastEstimate = -1;
+    note = -1;
+    lastBend = -1;
+    awayCount = 0;
+}
+
+void PitchToMidi::skip(int numSamples)
+{
+    position += numSamples;
+    fastEnvelope = slowEnvelope = 0;
+    isJumpArmed = true;
+    isOnsetDetectorStale = true;
+}
+
+void PitchToMidi::process(const float* input, int numSamples, const PitchEstimate& estimate, juce::MidiBuffer& midi)
+{
+    if (isOnsetDetectorStale)
+    {
+        onsetDetector.reset();
+        onsetDetectorStart = position;
+        isOnsetDetectorStale = false;
+    }
+
+    // Block-rate events go after anything sample-accurate this block
+    int eventOffset = 0;
+    bool startedThisBlock = false;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float level = std::abs(input[i]);
+        fastEnvelope += (level > fastEnvelope ? fastAttack : fastRelease) * (level - fastEnvelope);
+        slowEnvelope += slowCoefficient * (fastEnvelope - slowEnvelope);
+
+        const juce::int64 now = position + i;
+
+        if (state != State::idle && fastEnvelope < releaseLevel)
+        {
+            stop(midi, i);
+            eventOffset = i;
+            continue;
+        }
+
+        // A jump over the slow envelope, or sound arriving gradually while idle.
+        // After a jump the slow envelope takes longer than the refractory time
+        // to catch up, and the note-on has usually gone out by then, so another
+        // jump only counts once it has.
+        if (fastEnvelope <= slowEnvelope)
+            isJumpArmed = true;
+
+        const bool isJump = isJumpArmed && fastEnvelope > slowEnvelope * onsetRatio;
+        const bool isOnset = fastEnvelope > gateLevel
+                          && now - lastOnset >= refractorySamples
+                          && (isJump || (state == State::idle && slowEnvelope > gateLevel));
+
+        if (isOnset)
+        {
+            if (state == State::sounding)
+            {
+                stop(midi, i);
+                eventOffset = i;
+            }
+
+            state = State::pending;
+            onsetPosition = lastOnset = now;
+            isJumpArmed = false;
+            onsetPeak = 0;
+        }
+
+        if (state == State::pending)
+            onsetPeak = juce::jmax(onsetPeak, fastEnvelope);
+    }
+
+    position += numSamples;
+    onsetDetector.pushSamples(input, numSamples);
+
+    const bool isNew = estimate.samplePosition != lastEstimate;
+    lastEstimate = estimate.samplePosition;
+
+    if (state == State::pending)
+    {
+        const double frequency = getOnsetFrequency(estimate);
+        if (frequency > 0)
+        {
+            // -60 dBFS to full scale across the velocity range
+            const float peakDb = juce::Decibels::gainToDecibels(onsetPeak, -60.0f);
+            velocity = juce::jlimit(1, 127, juce::roundToInt(127.0f * (1.0f + peakDb / 60.0f)));
+
+            const int onsetOffset = static_cast<int> (onsetPosition - (position - numSamples));
+            startNote(midi, 69.0 + 12.0 * std::log2(frequency / 440.0), juce::jmax(eventOffset, onsetOffset));
+            startedThisBlock = true;
+        }
+        else if (position - onsetPosition > pendingTimeoutSamples)
+        {
+            // Never voiced: a consonant, a click, a breath
+            state = State::idle;
+        }
+    }
+
+    if (state == State::sounding && ! startedThisBlock && isNew && isUsable(estimate))
+    {
+        const double midiPitch = 69.0 + 12.0 * std::log2(estimate.frequency / 440.0);
+        awayCount = std::abs(midiPitch - note) >= 1.0 ? awayCount + 1 : 0;
+
+        if (awayCount >= awayEstimatesForNewNote)
+        {
+            stop(midi, eventOffset);
+            startNote(midi, midiPitch, eventOffset);
+        }
+        else
+        {
+            sendBend(midi, midiPitch, eventOffset);
+        }
+    }
+}
+
+void PitchToMidi::stop(juce::MidiBuffer& midi, int sampleOffset)
+{
+    if (state == State::sounding)
+        midi.addEvent(juce::MidiMessage::noteOff(channel, note), sampleOffset);
+
+    state = State::idle;
+    note = -1;
+    awayCount = 0;
+}
+
+void PitchToMidi::startNote(juce::MidiBuffer& midi, double midiPitch, int sampleOffset)
+{
+    note = juce::jlimit(0, 127, juce::roundToInt(midiPitch));
+
+    // The bend goes first so the note starts in tune
+    lastBend = -1;
+    sendBend(midi, midiPitch, sampleOffset);
+    midi.addEvent(juce::MidiMessage::noteOn(channel, note, static_cast<juce::uint8> (velocity)), sampleOffset);
+
+    state = State::sounding;
+    awayCount = 0;
+}
+
+void PitchToMidi::sendBend(juce::MidiBuffer& midi, double midiPitch, int sampleOffset)
+{
+    const double semitones = juce::jlimit(-bendRangeSemitones, bendRangeSemitones, midiPitch - note);
+    const int bend = juce::jlimit(0, 16383, 8192 + juce::roundToInt(semitones / bendRangeSemitones * 8191.0));
+
+    if (bend != lastBend)
+    {
+        midi.addEvent(juce::MidiMessage::pitchWheel(channel, bend), sampleOffset);
+        lastBend = bend;
+    }
+}
+
+bool PitchToMidi::isUsable(const PitchEstimate& estimate) const
+{
+    return estimate.frequency > 0
+        && estimate.voicedProbability >= voicedThreshold
+        && position - estimate.samplePosition <= maxAgeSamples;
+}
+
+double PitchToMidi::getOnsetFrequency(const PitchEstimate& trackerEstimate) const
+{
+    // The middle of the short window has to be past the onset's transient
+    auto estimate = onsetDetector.getEstimate();
+    estimate.samplePosition += onsetDetectorStart;
+    const auto centre = estimate.samplePosition - onsetDetector.getLatencyInSamples();
+    if (isUsable(estimate) && centre >= onsetPosition + settleSamples)
+        return estimate.frequency;
+
+    if (isUsable(trackerEstimate) && trackerEstimate.samplePosition >= onsetPosition + settleSamples)
+        return trackerEstimate.frequency;
+
+    return -1.0;
+}
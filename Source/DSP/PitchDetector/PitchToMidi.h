@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    PitchToMidi.h
+    Created: 18 Oct 2026 3:26:51am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MpmDetector.h"
+#include "PitchAnalyser.h"
+
+// Turns the input and the pitch tracker's estimates into MIDI notes.
+//
+// Onsets and releases come from two envelope followers run on every sample,
+// so note-offs land on the sample the level drops. The tracker lags too far
+// behind for note-ons, so their pitch comes from a short MPM window run
+// here on the input; the tracker is only the fallback for voices too low
+// for that window. A note-on waits for the first voiced estimate centred
+// settleSeconds past the onset, which takes about onsetWindowSeconds +
+// settleSeconds plus a hop (around 20 ms). It goes out at the onset's offset
+// if that is still in this block, and otherwise at the start of the block
+// the pitch became known, so it is only sample-accurate when blocks are
+// longer than that. While a note sounds, the tracker's distance from it goes
+// out as pitch bend, and a new note is started legato once the pitch has
+// settled a semitone or more away.
+//
+// Nothing allocates after prepare; each block adds at most
+// maxEventsPerBlock events, which fits the MIDI space the plugin wrappers
+// reserve.
+class PitchToMidi
+{
+public:
+    void prepare(double sampleRate);
+
+    // Forgets any sounding note without sending its note-off
+    void reset();
+
+    // Audio thread. input is the channel the estimates are made from.
+    void process(const float* input, int numSamples, const PitchEstimate& estimate, juce::MidiBuffer& midi);
+
+    // Audio thread. Ends any sounding note.
+    void stop(juce::MidiBuffer& midi, int sampleOffset);
+
+    // Audio thread, in place of process while the output is off. Keeps the
+    // clock in step with the analyser's, so estimates are still placed
+    // right when it comes back on.
+    void skip(int numSamples);
+
+    static constexpr int channel = 1;
+    static constexpr double bendRangeSemitones = 2.0;
+    static constexpr int maxEventsPerBlock = 8;
+
+private:
+    enum class State { idle, pending, sounding };
+
+    void startNote(juce::MidiBuffer& midi, double midiPitch, int sampleOffset);
+    void sendBend(juce::MidiBuffer& midi, double midiPitch, int sampleOffset);
+    bool isUsable(const PitchEstimate& estimate) const;
+
+    // The pitch to start a pending note on, or -1 if there isn't one yet
+    double getOnsetFrequency(const PitchEstimate& trackerEstimate) const;
+
+    double sampleRate = 48000.0;
+    float fastAttack = 0, fastRelease = 0, slowCoefficient = 0;
+    float fastEnvelope = 0, slowEnvelope = 0;
+    bool isJumpArmed = true;
+
+    // Short-window detector for note-ons. Its positions count from
+    // onsetDetectorStart; it restarts after the output has been off.
+    MpmDetector onsetDetector;
+    juce::int64 onsetDetectorStart = 0;
+    bool isOnsetDetectorStale = false;
+
+    State state = State::idle;
+    juce::int64 position = 0;           // input samples since prepare
+    juce::int64 onsetPosition = 0;
+    juce::int64 lastOnset = 0;
+    juce::int64 lastEstimate = -1;      // samplePosition of the last estimate used
+    float onsetPeak = 0;
+    int note = -1;
+    int velocity = 0;
+    int lastBend = -1;
+    int awayCount = 0;                  // estimates in a row a semitone or more off
+
+    juce::int64 settleSamples = 0, refractorySamples = 0, pendingTimeoutSamples = 0, maxAgeSamples = 0;
+
+    static constexpr float gateLevel = 0.0056f;     // -45 dBFS
+    static constexpr float releaseLevel = 0.0028f;  // -51 dBFS
+    static constexpr float onsetRatio = 2.0f;       // +6 dB over the slow envelope
+    static constexpr double voicedThreshold = 0.5;
+    static constexpr double settleSeconds = 0.005;
+    static constexpr double refractorySeconds = 0.03;
+    static constexpr double pendingTimeoutSeconds = 0.2;
+    static constexpr int awayEstimatesForNewNote = 2;
+
+    // Lags up to the window, so this also sets the lowest note-on pitch
+    // (80 Hz); a new estimate every quarter window
+    static constexpr double onsetWindowSeconds = 0.0125;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchToMidi)
+};
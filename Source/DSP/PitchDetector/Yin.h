@@ -11,30 +11,33 @@
 #pragma once
 
 #include <algorithm>
-#include <complex>
-#include <map>
-#include <tuple>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include <JuceHeader.h>
 
-#define YIN_THRESHOLD 0.20
 #define PYIN_PA 0.01
 #define PYIN_N_THRESHOLDS 100
 #define PYIN_MIN_THRESHOLD 0.01
-#define RELAX_TIME (50)	// In milliseconds
+#define PYIN_MIN_FREQUENCY 20.0
+#define PYIN_MAX_FREQUENCY 3000.0
+#define PYIN_BINS_PER_SEMITONE 5
+#define PYIN_MAX_JUMP 25			// In bins, per frame
+#define PYIN_SWITCH_PROB 0.01		// Chance of voicing changing between frames
+#define PYIN_YIN_TRUST 0.5
+#define PYIN_MAX_CANDIDATES 16
+#define PYIN_MAX_LOOKBACK 32		// In frames
+#define RELAX_TIME (20)	// Viterbi lookback, in milliseconds
 #define LEVEL_THRESHOLD_IN_DB(A) (20 * log10((A)))
 
 using fucking = const float;
 
 namespace Yin {
 
-	struct Yin_Result {
-		size_t N;
-		std::vector<double> out_real;
-		std::vector<double> yin_buffer;
-	};
-
 	/// <summary>
 	/// Beta distribution params
 	/// </summary>
@@ -54,117 +57,319 @@ namespace Yin {
 	0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000,
 	0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000 };
 
+	/// <summary>
+	/// The vertex of the parabola through array[x - 1], array[x] and
+	/// array[x + 1], as (position, value). Also used by MpmDetector.
+	/// </summary>
+	inline std::pair<double, double> parabolic_interpolation(const std::vector<double>& array, size_t x)
+	{
+		if (x < 1 || x + 1 >= array.size())
+			return std::make_pair(static_cast<double>(x), array[x]);
+
+		double den = array[x + 1] + array[x - 1] - 2 * array[x];
+		double delta = array[x - 1] - array[x + 1];
+		return (!den) ? std::make_pair(static_cast<double>(x), array[x])
+			: std::make_pair(x + delta / (2 * den),
+				array[x] - delta * delta / (8 * den));
+	}
+
+	/// <summary>
+	/// Probabilistic YIN (pYIN) pitch tracker. Every buffer is sized in
+	/// SetBufferSize and SetHopSize, so Pitch never allocates.
+	///
+	/// A frame is 2 * bufferSize samples: the difference function integrates
+	/// over the first bufferSize of them, at lags up to bufferSize - 1, and is
+	/// computed as energies from prefix sums minus an FFT cross-correlation.
+	///
+	/// Rather than one threshold, every trough of the normalised difference
+	/// becomes a candidate weighted by the share of the Beta-distributed
+	/// thresholds that would have picked it. An HMM over pitch bins, each with
+	/// a voiced and an unvoiced state, is decoded with a fixed-lag Viterbi:
+	/// back-pointers for the last few frames live in a ring, so each frame
+	/// costs the same however long the track runs.
+	/// </summary>
 	class Yin_Pitch {
 
 	private:
+		struct Candidate {
+			double frequency = 0;
+			double probability = 0;
+		};
+
+		struct Frame {
+			std::array<Candidate, PYIN_MAX_CANDIDATES> candidates;
+			size_t numCandidates = 0;
+			double voicedProbability = 0;
+		};
+
 		size_t bufferSize = 0;
 		size_t sampleRate = 48000;
-		size_t relaxFeed = 5;
-		size_t relaxDog = 0;
+		size_t hopSize = 0;
 
-		std::vector<double>* freqWindow = nullptr;
+		double threshold = -60;
 
-		Yin_Result* rslt = nullptr;
+		// Scratch for the difference function
+		std::unique_ptr<juce::dsp::FFT> fft;
+		std::vector<float> fftWindow;	// first bufferSize samples, zero-padded
+		std::vector<float> fftFrame;	// whole frame, zero-padded
+		std::vector<double> energy;		// energy[k] = sum of x[i]^2 for i < k
+		std::vector<double> yin_buffer;
 
-		double threshold = -60;
+		// betaCdf[k] = sum of Beta_Distribution[i] for i < k
+		std::array<double, PYIN_N_THRESHOLDS + 1> betaCdf{};
+
+		// HMM: states [0, numBins) are voiced, [numBins, 2 * numBins) unvoiced
+		double minFrequency = PYIN_MIN_FREQUENCY;
+		size_t numBins = 0;
+		std::array<double, 2 * PYIN_MAX_JUMP + 1> logJump{};
+		double logStay = 0, logSwitch = 0;
+		std::vector<double> delta, nextDelta, logObservation;
+		std::vector<double> bestSource;				// per bin, for one destination voicing
+		std::vector<std::uint16_t> bestSourceState;
+
+		// Rings of lookback + 1 frames
+		size_t lookback = 0;
+		std::vector<std::uint16_t> psi;				// best predecessor of each state
+		std::vector<Frame> frames;
+		size_t newestFrame = 0;
+		size_t numFrames = 0;
+		size_t decodeDelay = 0;
+		double decodedVoicedProbability = 0;
+
+		// d(tau) = sum (x[j] - x[j + tau])^2 over j < bufferSize
+		//        = e(0, W) + e(tau, tau + W) - 2 r(tau)
+		void difference(fucking* audio_buffer)
+		{
+			const size_t frameSize = 2 * bufferSize;
+			const size_t fftSize = fft->getSize();
+
+			energy[0] = 0;
+			for (size_t i = 0; i < frameSize; ++i)
+				energy[i + 1] = energy[i] + static_cast<double>(audio_buffer[i]) * audio_buffer[i];
+
+			std::fill(fftWindow.begin(), fftWindow.end(), 0.0f);
+			std::fill(fftFrame.begin(), fftFrame.end(), 0.0f);
+			juce::FloatVectorOperations::copy(fftWindow.data(), audio_buffer, static_cast<int>(bufferSize));
+			juce::FloatVectorOperations::copy(fftFrame.data(), audio_buffer, static_cast<int>(frameSize));
+
+			fft->performRealOnlyForwardTransform(fftWindow.data(), true);
+			fft->performRealOnlyForwardTransform(fftFrame.data(), true);
+
+			// r(tau) = sum window[j] * frame[j + tau]: conj(Window) * Frame.
+			// The transform is at least 3 * bufferSize long, so no lag wraps.
+			for (size_t bin = 0; bin <= fftSize / 2; ++bin)
+			{
+				const float re = fftWindow[2 * bin] * fftFrame[2 * bin] + fftWindow[2 * bin + 1] * fftFrame[2 * bin + 1];
+				const float im = fftWindow[2 * bin] * fftFrame[2 * bin + 1] - fftWindow[2 * bin + 1] * fftFrame[2 * bin];
+				fftFrame[2 * bin] = re;
+				fftFrame[2 * bin + 1] = im;
+			}
+			fft->performRealOnlyInverseTransform(fftFrame.data());
 
-		static std::pair<double, double>parabolic_interpolation(const std::vector<double>& array, int x_)
+			const double windowEnergy = energy[bufferSize];
+			for (size_t tau = 0; tau < bufferSize; ++tau)
+			{
+				const double laggedEnergy = energy[tau + bufferSize] - energy[tau];
+				yin_buffer[tau] = std::max(0.0, windowEnergy + laggedEnergy - 2.0 * fftFrame[tau]);
+			}
+		}
+
+		static void cumulative_mean_normalized_difference(std::vector<double>& yin_buffer)
 		{
-			int x_adjusted;
-			double x = (double)x_;
+			double running_sum = 0.0f;
+
+			yin_buffer[0] = 1;
+
+			for (size_t tau = 1; tau < yin_buffer.size(); tau++) {
+				running_sum += yin_buffer[tau];
+				yin_buffer[tau] = running_sum > 0 ? yin_buffer[tau] * tau / running_sum : 1;
+			}
+		}
+
+		// Number of thresholds at or below value
+		static size_t thresholds_below(double value) {
+			if (!(value < PYIN_N_THRESHOLDS * PYIN_MIN_THRESHOLD)) return PYIN_N_THRESHOLDS;
+			return value > 0 ? static_cast<size_t>(value / PYIN_MIN_THRESHOLD) : 0;
+		}
 
-			if (x < 1) {
-				x_adjusted = (array[x] <= array[x + 1]) ? x : x + 1;
+		static void add_candidate(Frame& frame, double frequency, double probability) {
+			for (size_t i = 0; i < frame.numCandidates; ++i) {
+				if (frame.candidates[i].frequency == frequency) {
+					frame.candidates[i].probability += probability;
+					frame.voicedProbability += probability;
+					return;
+				}
 			}
-			else if (x > signed(array.size()) - 1) {
-				x_adjusted = (array[x] <= array[x - 1]) ? x : x - 1;
+
+			size_t slot = frame.numCandidates;
+			if (slot == PYIN_MAX_CANDIDATES) {
+				// Full: the least likely one makes way
+				slot = 0;
+				for (size_t i = 1; i < PYIN_MAX_CANDIDATES; ++i)
+					if (frame.candidates[i].probability < frame.candidates[slot].probability) slot = i;
+				if (frame.candidates[slot].probability >= probability) return;
+				frame.voicedProbability -= frame.candidates[slot].probability;
 			}
 			else {
-				double den = array[x + 1] + array[x - 1] - 2 * array[x];
-				double delta = array[x - 1] - array[x + 1];
-				return (!den) ? std::make_pair(x, array[x])
-					: std::make_pair(x + delta / (2 * den),
-						array[x] - delta * delta / (8 * den));
+				++frame.numCandidates;
 			}
-			return std::make_pair(x_adjusted, array[x_adjusted]);
+
+			frame.candidates[slot] = { frequency, probability };
+			frame.voicedProbability += probability;
 		}
 
-		static void acorr_r(fucking* audio_buffer, size_t& size, Yin::Yin_Result*& fuck)
-		{
-			double r = 0;
-			for (size_t tao = 1; tao < size; ++tao) {
-				r = 0;
-				for (size_t j = 0; j < size; ++j) {
-					r += audio_buffer[j] * audio_buffer[j + tao];
-				}
-				fuck->out_real.push_back(r);
+		// A threshold s picks the first trough that dips below it, so trough k
+		// takes the thresholds between its own value and the lowest trough
+		// before it. Thresholds below every trough fall back to the global
+		// minimum, discounted by PYIN_PA.
+		void extract_candidates(Frame& frame) const {
+			const size_t size = yin_buffer.size();
+			const size_t minTau = std::max<size_t>(2, static_cast<size_t>(sampleRate / PYIN_MAX_FREQUENCY));
+			const size_t maxTau = std::min(size - 2, static_cast<size_t>(std::ceil(sampleRate / minFrequency)));
+
+			double lowestSoFar = std::numeric_limits<double>::infinity();
+			size_t globalTau = 0;
+
+			for (size_t tau = minTau; tau <= maxTau; ++tau) {
+				const double value = yin_buffer[tau];
+				if (!(value < yin_buffer[tau - 1] && value <= yin_buffer[tau + 1]) || value >= lowestSoFar)
+					continue;
+
+				const double mass = betaCdf[thresholds_below(lowestSoFar)] - betaCdf[thresholds_below(value)];
+				lowestSoFar = value;
+				globalTau = tau;
+
+				if (mass > 0)
+					add_candidate(frame, sampleRate / parabolic_interpolation(yin_buffer, tau).first, mass);
+			}
+
+			if (globalTau != 0) {
+				const double mass = PYIN_PA * betaCdf[thresholds_below(lowestSoFar)];
+				if (mass > 0)
+					add_candidate(frame, sampleRate / parabolic_interpolation(yin_buffer, globalTau).first, mass);
 			}
-			fuck->N = fuck->out_real.size();
 		}
 
-		static void difference(fucking* audio_buffer, size_t& size, Yin::Yin_Result* ya)
-		{
-			acorr_r(audio_buffer, size, ya);
+		int frequency_to_bin(double frequency) const {
+			return static_cast<int>(std::lround(12.0 * PYIN_BINS_PER_SEMITONE * std::log2(frequency / minFrequency)));
+		}
 
-			for (int tau = 0; tau < ya->N; tau++)
-				ya->yin_buffer.push_back(ya->out_real[0] + ya->out_real[1] - 2 * ya->out_real[tau]);
+		double bin_to_frequency(size_t bin) const {
+			return minFrequency * std::exp2(bin / (12.0 * PYIN_BINS_PER_SEMITONE));
 		}
 
-		static void cumulative_mean_normalized_difference(std::vector<double>& yin_buffer)
-		{
-			double running_sum = 0.0f;
+		// Sizes the HMM and its rings for the current rate, buffer and hop
+		void allocate_tracker() {
+			minFrequency = std::max(PYIN_MIN_FREQUENCY, sampleRate / static_cast<double>(bufferSize - 2));
+			numBins = static_cast<size_t>(std::max(1, frequency_to_bin(PYIN_MAX_FREQUENCY) + 1));
+			jassert(2 * numBins <= std::numeric_limits<std::uint16_t>::max());
+
+			const size_t hop = hopSize > 0 ? hopSize : bufferSize;
+			lookback = std::min<size_t>(PYIN_MAX_LOOKBACK,
+				static_cast<size_t>(std::lround(RELAX_TIME * 0.001 * sampleRate / hop)));
+
+			delta.assign(2 * numBins, 0.0);
+			nextDelta.assign(2 * numBins, 0.0);
+			logObservation.assign(2 * numBins, 0.0);
+			bestSource.assign(numBins, 0.0);
+			bestSourceState.assign(numBins, 0);
+			psi.assign((lookback + 1) * 2 * numBins, 0);
+			frames.assign(lookback + 1, Frame{});
+			Reset();
+		}
 
-			yin_buffer[0] = 1;
+		void observe(const Frame& frame) {
+			static constexpr double floor = 1e-30;
 
-			for (int tau = 1; tau < signed(yin_buffer.size()); tau++) {
-				running_sum += yin_buffer[tau];
-				yin_buffer[tau] *= tau / running_sum;
+			std::fill(logObservation.begin(), logObservation.begin() + numBins, 0.0);
+			double voiced = 0;
+			for (size_t i = 0; i < frame.numCandidates; ++i) {
+				const int bin = frequency_to_bin(frame.candidates[i].frequency);
+				if (bin < 0 || bin >= static_cast<int>(numBins)) continue;
+				logObservation[bin] += PYIN_YIN_TRUST * frame.candidates[i].probability;
+				voiced += PYIN_YIN_TRUST * frame.candidates[i].probability;
+			}
+
+			const double unvoiced = std::log(std::max(floor, (1.0 - voiced) / numBins));
+			for (size_t bin = 0; bin < numBins; ++bin) {
+				logObservation[bin] = std::log(std::max(floor, logObservation[bin]));
+				logObservation[numBins + bin] = unvoiced;
 			}
 		}
 
-		static size_t absolute_threshold(std::vector<double>& yin_buffer)
-		{
-			size_t size = yin_buffer.size();
-			int tau;
-			for (tau = 2; tau < size; tau++) {
-				if (yin_buffer[tau] < YIN_THRESHOLD) {
-					while (tau + 1 < size && yin_buffer[tau + 1] < yin_buffer[tau]) {
-						tau++;
+		// One Viterbi step into the newest frame's slot. Pitch moves the same
+		// way in voiced and unvoiced states, so the best source voicing is
+		// picked per bin before the jump window is searched.
+		void advance() {
+			std::uint16_t* row = psi.data() + newestFrame * 2 * numBins;
+
+			for (size_t voicing = 0; voicing < 2; ++voicing) {
+				const double fromVoiced = voicing == 0 ? logStay : logSwitch;
+				const double fromUnvoiced = voicing == 0 ? logSwitch : logStay;
+
+				for (size_t bin = 0; bin < numBins; ++bin) {
+					const double v = delta[bin] + fromVoiced;
+					const double u = delta[numBins + bin] + fromUnvoiced;
+					bestSource[bin] = v >= u ? v : u;
+					bestSourceState[bin] = static_cast<std::uint16_t>(v >= u ? bin : numBins + bin);
+				}
+
+				for (size_t bin = 0; bin < numBins; ++bin) {
+					const size_t first = bin >= PYIN_MAX_JUMP ? bin - PYIN_MAX_JUMP : 0;
+					const size_t last = std::min(numBins - 1, bin + PYIN_MAX_JUMP);
+
+					double best = -std::numeric_limits<double>::infinity();
+					size_t bestBin = bin;
+					for (size_t from = first; from <= last; ++from) {
+						const double score = bestSource[from] + logJump[from + PYIN_MAX_JUMP - bin];
+						if (score > best) { best = score; bestBin = from; }
 					}
-					break;
+
+					const size_t state = voicing * numBins + bin;
+					nextDelta[state] = best + logObservation[state];
+					row[state] = bestSourceState[bestBin];
 				}
 			}
-			if (tau >= size - 1) return -1;
-			return (yin_buffer[tau] >= YIN_THRESHOLD) ? -1 : tau;
-		}
 
-		static void vector_right_shifting(std::vector<double>& vec) {
-			for (size_t i = vec.size() - 1; i > 0; i--) {
-				vec[i] = vec[i - 1];
-			}
+			// Keep the scores near zero so they never run off
+			const double top = *std::max_element(nextDelta.begin(), nextDelta.end());
+			for (size_t state = 0; state < 2 * numBins; ++state)
+				delta[state] = nextDelta[state] - top;
 		}
 
-		static void vector_push_left(std::vector<double>& vec, double _in) {
-			vector_right_shifting(vec);
-			vec[0] = _in;
-		}
+		// Traces the best path back up to lookback frames and returns the
+		// frequency it passes through there, or -1 if that frame is unvoiced
+		double decode() {
+			size_t state = static_cast<size_t>(std::max_element(delta.begin(), delta.end()) - delta.begin());
+			size_t slot = newestFrame;
 
-		static void vector_flush_zero(std::vector<double>& vec) {
-			for (size_t i = 0; i < vec.size(); i++) vec[i] = 0;
-		}
+			decodeDelay = std::min(lookback, numFrames - 1);
+			for (size_t step = 0; step < decodeDelay; ++step) {
+				state = psi[slot * 2 * numBins + state];
+				slot = (slot + frames.size() - 1) % frames.size();
+			}
 
-		static void vector_get_average(std::vector<double>& vec, double& _out) {
-			double t = 0;
-			for (size_t i = 0; i < vec.size(); i++) {
-				t += vec[i];
+			const Frame& frame = frames[slot];
+			decodedVoicedProbability = frame.voicedProbability;
+			if (state >= numBins) return -1;
+
+			// The candidate the path went through, if it was near enough
+			double frequency = bin_to_frequency(state);
+			int nearest = PYIN_BINS_PER_SEMITONE + 1;
+			for (size_t i = 0; i < frame.numCandidates; ++i) {
+				const int distance = std::abs(frequency_to_bin(frame.candidates[i].frequency) - static_cast<int>(state));
+				if (distance < nearest) {
+					nearest = distance;
+					frequency = frame.candidates[i].frequency;
+				}
 			}
-			_out = t / vec.size();
+			return frequency;
 		}
 
-		bool AboveThreshold(fucking* audio_buffer, size_t& size) {
+		bool AboveThreshold(fucking* audio_buffer, size_t size) const {
 			double level = 0;
 			for (size_t i = 0; i < size; i++) {
-				level += abs(audio_buffer[i]);
+				level += std::abs(audio_buffer[i]);
 			}
 			level /= size;
 			return LEVEL_THRESHOLD_IN_DB(level) > threshold;
@@ -176,12 +381,49 @@ namespace Yin {
 
 
 	public:
-		~Yin_Pitch() { if (freqWindow != nullptr) delete freqWindow; }
+		Yin_Pitch() {
+			for (size_t i = 0; i < PYIN_N_THRESHOLDS; ++i)
+				betaCdf[i + 1] = betaCdf[i] + Beta_Distribution[i];
+
+			// Triangular pitch jumps
+			double total = 0;
+			for (int d = -PYIN_MAX_JUMP; d <= PYIN_MAX_JUMP; ++d)
+				total += PYIN_MAX_JUMP + 1 - std::abs(d);
+			for (int d = -PYIN_MAX_JUMP; d <= PYIN_MAX_JUMP; ++d)
+				logJump[d + PYIN_MAX_JUMP] = std::log((PYIN_MAX_JUMP + 1 - std::abs(d)) / total);
+
+			logStay = std::log(1.0 - PYIN_SWITCH_PROB);
+			logSwitch = std::log(PYIN_SWITCH_PROB);
+		}
 
+		// Allocates; call from prepare, not the audio thread
 		void SetBufferSize(size_t _bs) {
-			bufferSize = _bs;
-			relaxFeed = RELAX_TIME / (bufferSize / (double)sampleRate * 1000);
-			freqWindow = new std::vector<double>(relaxFeed, 440.0);
+			bufferSize = std::max<size_t>(_bs, 4);
+
+			const int order = juce::roundToInt(std::ceil(std::log2(3.0 * bufferSize)));
+			fft = std::make_unique<juce::dsp::FFT>(order);
+			fftWindow.assign(2 * static_cast<size_t>(fft->getSize()), 0.0f);
+			fftFrame.assign(2 * static_cast<size_t>(fft->getSize()), 0.0f);
+			energy.assign(2 * bufferSize + 1, 0.0);
+			yin_buffer.assign(bufferSize, 0.0);
+
+			allocate_tracker();
+		}
+
+		// Samples between calls to Pitch; sets how many frames the Viterbi
+		// looks back. Allocates.
+		void SetHopSize(size_t hop) {
+			hopSize = std::max<size_t>(hop, 1);
+			allocate_tracker();
+		}
+
+		// Forgets the frames tracked so far. Doesn't allocate.
+		void Reset() {
+			std::fill(delta.begin(), delta.end(), 0.0);
+			newestFrame = 0;
+			numFrames = 0;
+			decodeDelay = 0;
+			decodedVoicedProbability = 0;
 		}
 
 		void prepare(juce::dsp::ProcessSpec& spec) {
@@ -189,35 +431,37 @@ namespace Yin {
 			SetBufferSize(spec.maximumBlockSize);
 		}
 
+		size_t GetFrameSize() const { return 2 * bufferSize; }
+
+		// Most frames the Viterbi traces back
+		size_t GetLookback() const { return lookback; }
+
+		// How many frames behind the newest one the last estimate is
+		size_t GetDecodeDelay() const { return decodeDelay; }
+
+		// The chance, from 0 to 1, that the last estimate's frame is voiced
+		double GetVoicedProbability() const { return decodedVoicedProbability; }
+
+		// audio_buffer holds GetFrameSize() samples. Returns the decoded
+		// frequency in Hz GetDecodeDelay() frames back, or -1 where the path
+		// is unvoiced. Frames below the level threshold count as unvoiced.
 		double Pitch(fucking* audio_buffer) {
-			int tau_estimate;
-			double ret = -1;
+			newestFrame = (newestFrame + 1) % frames.size();
+			numFrames = std::min(numFrames + 1, frames.size());
 
-			if (AboveThreshold(audio_buffer, bufferSize)) {
-				// Get new pitch
-				rslt = new Yin_Result;
-				difference(audio_buffer, bufferSize, rslt);
-				cumulative_mean_normalized_difference(rslt->yin_buffer);
-				tau_estimate = absolute_threshold(rslt->yin_buffer);
-
-				if (tau_estimate != -1) {
-					ret = sampleRate /
-						std::get<0>(parabolic_interpolation(rslt->yin_buffer, tau_estimate));
-				}
-				else {
-					ret = -1;
-				}
-				delete rslt;
+			Frame& frame = frames[newestFrame];
+			frame.numCandidates = 0;
+			frame.voicedProbability = 0;
 
-				if (ret > 20 && ret < 3000) {
-					vector_push_left(*freqWindow, ret);
-				}
-				else {
-					vector_push_left(*freqWindow, freqWindow->data()[0]);
-				}
-				vector_get_average(*freqWindow, ret);
+			if (AboveThreshold(audio_buffer, bufferSize)) {
+				difference(audio_buffer);
+				cumulative_mean_normalized_difference(yin_buffer);
+				extract_candidates(frame);
 			}
-			return ret;
+
+			observe(frame);
+			advance();
+			return decode();
 		}
 	};
 
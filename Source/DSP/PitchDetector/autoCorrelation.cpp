@@ -10,8 +10,7 @@
 
 #include "autoCorrelation.h"
 
-//FFT size = 2048 (11 power 2)
-AutoCorrelation::AutoCorrelation() : forwardFFT(11)
+AutoCorrelation::AutoCorrelation()
 {
     lastNote = -1;
     lastNotePos = 0;
@@ -25,6 +24,29 @@ void AutoCorrelation::prepare(double SampleRate, int SampleSize)
     relaxFeed = 100 / (SampleRate / SampleSize);
     windowNextFill = 0;
     curSample = 0;
+
+    jassert(windowSizePower2 <= 13);    // windowSamples holds 8192
+    windowSize = 1 << windowSizePower2;
+    correlationFFT = std::make_unique<juce::dsp::FFT>(windowSizePower2 + 1);
+    FFTdata.assign(4 * static_cast<size_t>(windowSize), 0.0f);
+
+    inputRing.assign(2 * static_cast<size_t>(windowSize), 0.0f);
+    ringMask = inputRing.size() - 1;
+    samplesWritten = 0;
+
+    slidingCorrelation.assign(static_cast<size_t>(windowSize), 0.0);
+    reset();
+}
+
+void AutoCorrelation::reset()
+{
+    std::fill(inputRing.begin(), inputRing.end(), 0.0f);
+    std::fill(windowSamples, windowSamples + windowSize, 0.0f);
+    samplesWritten = 0;
+    windowNextFill = 0;
+    curSample = 0;
+    slidingStart = -1;
+    clarity = 0;
 }
 
 void AutoCorrelation::process(const juce::dsp::AudioBlock<float> &inBlock, double* freq)
@@ -36,7 +58,6 @@ void AutoCorrelation::process(const juce::dsp::AudioBlock<float> &inBlock, doubl
 
     auto *src = inBlock.getChannelPointer(0);
 
-    windowSize = 1 << windowSizePower2;
     lastNotePos -= sampleSize;  //last note position is actually in previous block
     
     while(true){
@@ -52,16 +73,17 @@ void AutoCorrelation::process(const juce::dsp::AudioBlock<float> &inBlock, doubl
         if(windowNextFill >= windowSize){
             if (relaxDog == 0) {
                 oldFreq = newFreq;
-                newFreq = getFrequency();
+                lineariseWindow();
+                if (function == slidingFunction) newFreq = getFrequencySliding();
+                else if (function == fftFunction) newFreq = getFrequencyFFT();
+                else newFreq = getFrequency();
                 freqShiftDelta = (newFreq - oldFreq) / relaxFeed;
             }
             if (relaxDog >= relaxFeed) relaxDog = 0;
             else relaxDog++;
             *freq = relaxDog * freqShiftDelta + oldFreq;
             
-            //windowSamples left shift
-            for (int i = 0; i < windowSize - hoppingSize; i++)
-                windowSamples[i] = windowSamples[i + hoppingSize];
+            //the ring keeps the history, so the window just moves on
             windowNextFill -= hoppingSize;
             continue;
         }
@@ -72,7 +94,7 @@ void AutoCorrelation::process(const juce::dsp::AudioBlock<float> &inBlock, doubl
         }
         
         // keep copy sample from src to window
-        windowSamples[windowNextFill] = src[curSample];
+        inputRing[static_cast<size_t>(samplesWritten++) & ringMask] = src[curSample];
         curSample++;
         windowNextFill++;
     }
@@ -126,13 +148,122 @@ double AutoCorrelation::getFrequency()
 
     //calculating frequency
     if (thres <= noiseThres) {
+        clarity = 0;
         return -1;
     }
+    clarity = T > 1 ? ACF_PREV * correlationThres / thres : 0;
 
     //DIRECT_RETURN:
     return sampleRate / T;
 }
 
+void AutoCorrelation::pushSamples(const float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        inputRing[static_cast<size_t>(samplesWritten++) & ringMask] = samples[i];
+    lineariseWindow();
+}
+
+void AutoCorrelation::lineariseWindow()
+{
+    const auto start = static_cast<size_t>(samplesWritten - windowSize) & ringMask;
+    const auto first = juce::jmin(static_cast<size_t>(windowSize), inputRing.size() - start);
+    std::copy(inputRing.begin() + start, inputRing.begin() + start + first, windowSamples);
+    std::copy(inputRing.begin(), inputRing.begin() + (windowSize - first), windowSamples + first);
+}
+
+void AutoCorrelation::computeCorrelationFFT()
+{
+    // the FFT is planned in prepare for the window size at the time
+    jassert(correlationFFT != nullptr && correlationFFT->getSize() == 2 * windowSize);
+
+    std::fill(FFTdata.begin(), FFTdata.end(), 0.0f);
+    std::copy(windowSamples, windowSamples + windowSize, FFTdata.begin());
+
+    correlationFFT->performRealOnlyForwardTransform(FFTdata.data(), true);
+
+    // power spectrum, then back: the inverse is scaled by 1 / N, so the
+    // values match getFrequency's sums
+    for (int bin = 0; bin <= windowSize; ++bin) {
+        auto& re = FFTdata[2 * bin];
+        auto& im = FFTdata[2 * bin + 1];
+        re = re * re + im * im;
+        im = 0;
+    }
+    correlationFFT->performRealOnlyInverseTransform(FFTdata.data());
+}
+
+double AutoCorrelation::getFrequencyFFT()
+{
+    computeCorrelationFFT();
+    return frequencyFromCorrelation(FFTdata.data(), windowSize);
+}
+
+double AutoCorrelation::getFrequencySliding()
+{
+    const juce::int64 start = samplesWritten - windowSize;
+    const juce::int64 hop = start - slidingStart;
+
+    // pairs straddling both ends would need special cases, so lags stop a
+    // hop short of the window
+    const int lags = juce::jlimit(2, windowSize, juce::jmin(static_cast<int>(std::ceil(sampleRate / lowestFrequency)) + 2,
+                                                            windowSize - hoppingSize));
+    const int interval = recomputeHops > 0 ? recomputeHops : juce::jmax(1, windowSize / juce::jmax(1, hoppingSize));
+
+    if (slidingStart < 0 || hop <= 0 || hop > windowSize - lags || lags != slidingLags || hopsSinceRecompute >= interval) {
+        computeCorrelationFFT();
+        std::copy(FFTdata.begin(), FFTdata.begin() + lags, slidingCorrelation.begin());
+        slidingLags = lags;
+        hopsSinceRecompute = 0;
+    }
+    else {
+        // r(k) over [start, start + N) from r(k) over [old, old + N)
+        const juce::int64 old = slidingStart;
+        for (int k = 0; k < lags; ++k) {
+            double change = 0;
+            for (juce::int64 i = 0; i < hop; ++i) {
+                change -= static_cast<double>(inputAt(old + i)) * inputAt(old + i + k);
+                change += static_cast<double>(inputAt(old + windowSize - k + i)) * inputAt(old + windowSize + i);
+            }
+            slidingCorrelation[k] += change;
+        }
+        ++hopsSinceRecompute;
+    }
+    slidingStart = start;
+
+    for (int k = 0; k < lags; ++k)
+        sums[k] = static_cast<float>(slidingCorrelation[k]);
+    return frequencyFromCorrelation(sums, lags);
+}
+
+double AutoCorrelation::frequencyFromCorrelation(const float* correlation, int size)
+{
+    int T = 1;  //period represented in number of samples
+    float thres = correlationThres * correlation[0];   //determine thres
+    bool flag = false;  //flag be true while we get into second local peak region
+
+    //find second local peak
+    for (int k = 1; k < size; ++k){
+        // already get the peak
+        if (flag && correlation[k] <= correlation[k-1]){
+            T = k - 1;
+            break;
+        }
+
+        // already get into second local peak region
+        if (correlation[k] > correlation[k-1] && correlation[k] > thres){
+            flag = true;
+        }
+    }
+
+    if (thres <= noiseThres) {
+        clarity = 0;
+        return -1;
+    }
+    clarity = T > 1 ? correlation[T] / correlation[0] : 0;
+    return sampleRate / T;
+}
+
 int AutoCorrelation::findNote(){
     double freq = getFrequency();
     int note = round(log(freq / 440.0) / log(2) * 12 + 69);
@@ -149,45 +280,18 @@ int AutoCorrelation::SIMDfindNote(){
         juce::FloatVectorOperationsBase<float, int>::addWithMultiply(sums, &windowSamples[k], windowSamples[k], windowSize - k);
     }
     
-    int T = 1;  //period represented in number of samples
-    float thres = correlationThres * sums[0];   //determine thres
-    bool flag = false;  //flag be true while we get into second local peak region
-    
-    //find second local peak
-    for (int k = 1; k < windowSize; ++k){
-        // already get the peak
-        if (flag && sums[k] <= sums[k-1]){
-            T = k - 1;
-            break;
-        }
-        
-        // already get into second local peak region
-        if (sums[k] > sums[k-1] && sums[k] > thres){
-            flag = true;
-        }
-    }
-    
     //calculating note
-    double freq = sampleRate / T;
+    double freq = frequencyFromCorrelation(sums, windowSize);
     int note = round(log(freq / 440.0) / log(2) * 12 + 69);
-    if (note > 127 || note < 0 || thres <= noiseThres )
+    if (freq <= 0 || note > 127 || note < 0)
         return -1;
     return note;
 }
 
 int AutoCorrelation::FFTfindNote(){
-    // copy samples from window to FFTdata
-    std::fill (FFTdata.begin(), FFTdata.end(), 0);
-    std::copy (&windowSamples[0], &windowSamples[2047], FFTdata.begin());
-    
-    // do FFT
-    forwardFFT.performFrequencyOnlyForwardTransform(FFTdata.data());
-    
-    // calculate note
-    auto k = std::distance(FFTdata.begin(), std::max_element(FFTdata.begin(), FFTdata.end()));
-    double freq = (double)k / 2048 * sampleRate;
+    double freq = getFrequencyFFT();
     int note = round(log(freq / 440.0) / log(2) * 12 + 69);
-    if (note > 127 || note < 0 || FFTdata[k] <= noiseThres )
+    if (freq <= 0 || note > 127 || note < 0)
         return -1;
     return note;
 }
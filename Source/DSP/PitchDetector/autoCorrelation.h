@@ -19,28 +19,65 @@ class AutoCorrelation
 public:
 
     int LNL; //least note length
-    int function = 0;   // function to find note
-    int windowSizePower2 = 12;
+    int function = 0;   // function to find note (fftFunction: Wiener-Khinchin, slidingFunction: incremental)
+    int windowSizePower2 = 12;  // set before prepare, which plans the FFT for it
     int hoppingSize = 1024;
     float correlationThres = 0.6;
     float noiseThres = 0.05f;
+    float lowestFrequency = 40.0f;  // sets the lags the sliding correlation tracks
+    int recomputeHops = 0;  // sliding hops between full recomputes; 0 means once per window
     
+    static constexpr int fftFunction = 2;
+    static constexpr int slidingFunction = 3;
+
     AutoCorrelation();
     void prepare(double SampleRate, int SampleSize);
+    void reset();   // forgets the input without allocating
     void process(const juce::dsp::AudioBlock<float>& inBlock, double* freq);
+
+    // appends samples to the window without analysing, for driving the
+    // find functions directly (the benchmark does)
+    void pushSamples(const float* samples, int numSamples);
     
     // return frequency (Robin)
     double getFrequency();
 
+    // same as getFrequency, with the correlation taken as the inverse FFT of
+    // the zero-padded window's power spectrum: O(N log N) instead of O(N^2)
+    double getFrequencyFFT();
+
+    // same again, but the correlation is carried over from the last hop: the
+    // pairs that left the window are subtracted and the ones that entered are
+    // added, for lags up to lowestFrequency's period. That costs
+    // 2 * hop * lags, so per sample it doesn't depend on the hop. Every
+    // recomputeHops it is rebuilt with the FFT instead, so rounding can't
+    // build up.
+    double getFrequencySliding();
+
+    // the last find's peak over the correlation at lag 0: near 1 for a
+    // clean period, 0 for noise or no peak
+    float getClarity() const { return clarity; }
+
     // return note
     int findNote(); // Modified
     int SIMDfindNote();
-    int FFTfindNote();  //this FFT can process only with fixed window size (2048 here)
+    int FFTfindNote();
     
     // determine whether should we make noteOn message
     void buildingMidiMessage(int note, int notePos, juce::MidiBuffer& midiMessages);
     
 private:
+    // second local peak of a correlation holding size lags, or -1 for noise
+    double frequencyFromCorrelation(const float* correlation, int size);
+
+    // correlation of windowSamples into the front of FFTdata
+    void computeCorrelationFFT();
+
+    // copies the newest windowSize samples from the ring into windowSamples
+    void lineariseWindow();
+
+    float inputAt(juce::int64 position) const { return inputRing[static_cast<size_t>(position) & ringMask]; }
+
     double sampleRate;
     int sampleSize;
     
@@ -48,13 +85,25 @@ private:
     float windowSamples[8192] = {0};
     int windowNextFill;
     int curSample;
+
+    // input history: twice the window, so a hop's leaving samples are still there
+    std::vector<float> inputRing;
+    size_t ringMask = 0;
+    juce::int64 samplesWritten = 0;
+    float clarity = 0;
+
+    // for sliding: lags [0, slidingLags) of the window starting at slidingStart
+    std::vector<double> slidingCorrelation;
+    juce::int64 slidingStart = -1;
+    int slidingLags = 0;
+    int hopsSinceRecompute = 0;
     
     // for SIMD
     float sums[8192] = { 0 };
     
-    // for FFT
-    juce::dsp::FFT forwardFFT;
-    std::array<float, 4096> FFTdata;
+    // for FFT: twice the window, so the circular correlation doesn't wrap
+    std::unique_ptr<juce::dsp::FFT> correlationFFT;
+    std::vector<float> FFTdata;
     
     // for building midi message
     int lastNote;   //lastNote == -1 means there's no note sustaining
@@ -12,106 +12,191 @@
 
 Saturation::Saturation() {}
 
+void Saturation::setDrive(float newDrive)
+{
+    drive.setTargetValue(newDrive);
+}
+
+void Saturation::setMix(float newMix)
+{
+    mix.setTargetValue(newMix / 100.0f);
+}
+
+void Saturation::setVolume(float newVolume)
+{
+    volume.setTargetValue(juce::Decibels::decibelsToGain(newVolume));
+}
+
+void Saturation::setQualityProfile(const QualityProfile& newProfile)
+{
+    quality = newProfile;
+}
+
 void Saturation::prepare(juce::dsp::ProcessSpec& spec)
 {
-    oversampling.reset();
-    oversampling.initProcessing(static_cast<size_t> (spec.maximumBlockSize));
-
-    juce::dsp::ProcessSpec specOverSampling;
-    specOverSampling.maximumBlockSize = spec.maximumBlockSize * 3;
-    specOverSampling.sampleRate = spec.sampleRate * 4;
-    specOverSampling.numChannels = spec.numChannels;
-
-    compressor.prepare(specOverSampling);
-    compressor.setAttack(10.0f);
-    compressor.setRelease(50.0f);
-    compressor.setRatio(4.0f);
-    compressor.setThreshold(-4.0f);
+    sampleRate = spec.sampleRate;
+
+    for (int order = 0; order < numOversamplingOrders; ++order)
+    {
+        oversamplers[order] = std::make_unique<juce::dsp::Oversampling<float>>(spec.numChannels, static_cast<size_t> (order), quality.oversamplingFilter, quality.maxQualityOversampling);
+        oversamplers[order]->initProcessing(static_cast<size_t> (spec.maximumBlockSize));
+
+        juce::dsp::ProcessSpec specOverSampling;
+        specOverSampling.maximumBlockSize = spec.maximumBlockSize << order;
+        specOverSampling.sampleRate = spec.sampleRate * (1 << order);
+        specOverSampling.numChannels = spec.numChannels;
+
+        auto& compressor = compressors[order];
+        compressor.prepare(specOverSampling);
+        compressor.setAttack(10.0f);
+        compressor.setRelease(50.0f);
+        compressor.setRatio(4.0f);
+        compressor.setThreshold(-4.0f);
+    }
+
+    dryBuffer.setSize(static_cast<int> (spec.numChannels), static_cast<int> (spec.maximumBlockSize) << (numOversamplingOrders - 1));
+    rampBuffer.setSize(3, static_cast<int> (spec.maximumBlockSize) << (numOversamplingOrders - 1));
+    antialiasingStates.assign(spec.numChannels, {});
+
+    WaveShapers::Tube::getAntiderivativeTable();
+
+    activeOrder = -1;
+    isSleeping = false;
+    updateProcessingMode();
+}
+
+void Saturation::updateProcessingMode()
+{
+    const int order = juce::jlimit(0, numOversamplingOrders - 1, oversamplingOrder);
+    if (order == activeOrder && antialiasingOrder == activeAntialiasingOrder)
+        return;
+
+    activeOrder = order;
+    activeAntialiasingOrder = antialiasingOrder;
+    oversamplers[activeOrder]->reset();
+    compressors[activeOrder].reset();
+
+    // The ramps run at the oversampled rate
+    const double oversampledRate = sampleRate * (1 << activeOrder);
+    drive.reset(oversampledRate, ParameterSmoothing::rampLengthSeconds);
+    mix.reset(oversampledRate, ParameterSmoothing::rampLengthSeconds);
+    volume.reset(oversampledRate, ParameterSmoothing::rampLengthSeconds);
+    std::fill(antialiasingStates.begin(), antialiasingStates.end(), WaveShapers::AntialiasingState{});
+}
+
+float Saturation::getLatencyInSamples() const
+{
+    const int order = juce::jlimit(0, numOversamplingOrders - 1, oversamplingOrder);
+    if (oversamplers[order] == nullptr)
+        return 0.0f;
+
+    // ADAA delays the oversampled signal by half a sample per order
+    return oversamplers[order]->getLatencyInSamples() + 0.5f * antialiasingOrder / static_cast<float> (1 << order);
+}
+
+juce::int64 Saturation::getSettleSamples() const
+{
+    return static_cast<juce::int64> (std::ceil(getLatencyInSamples() + ringOutSeconds * sampleRate));
+}
+
+void Saturation::wakeUp()
+{
+    isSleeping = false;
+
+    oversamplers[activeOrder]->reset();
+    compressors[activeOrder].reset();
+    std::fill(antialiasingStates.begin(), antialiasingStates.end(), WaveShapers::AntialiasingState{});
+
+    // Nothing was heard while the parameters moved, so jump to their targets
+    drive.setCurrentAndTargetValue(drive.getTargetValue());
+    mix.setCurrentAndTargetValue(mix.getTargetValue());
+    volume.setCurrentAndTargetValue(volume.getTargetValue());
+}
+
+void Saturation::process(juce::dsp::AudioBlock<float>& block, juce::int64 silentInputSamples)
+{
+    updateProcessingMode();
+
+    // Every curve maps 0 to 0, so silence in is silence out once the
+    // oversampling filters have emptied; the block passes through as it is
+    if (silentInputSamples - static_cast<juce::int64> (block.getNumSamples()) >= getSettleSamples())
+    {
+        isSleeping = true;
+        return;
+    }
+
+    if (isSleeping)
+        wakeUp();
+
+    // Distortion Type, picked once per block
+    switch (static_cast<int> (distortionType))
+    {
+        case 1:  processWithShaper<WaveShapers::HardClip>(block);          break;
+        case 2:  processWithShaper<WaveShapers::QuadraticSoftClip>(block); break;
+        case 3:  processWithShaper<WaveShapers::Exponential>(block);       break;
+        case 4:  processWithShaper<WaveShapers::ArcTan>(block);            break;
+        case 5:  processWithShaper<WaveShapers::Tube>(block);              break;
+        default: jassertfalse;                                             break;
+    }
 }
 
-void Saturation::process(juce::dsp::AudioBlock<float>& block)
+template <typename Shaper>
+void Saturation::processWithShaper(juce::dsp::AudioBlock<float>& block)
 {
+    auto& oversampling = *oversamplers[activeOrder];
+    auto& compressor = compressors[activeOrder];
+
     juce::dsp::AudioBlock<float> blockOuput = oversampling.processSamplesUp(block);
-    for (int channel = 0; channel < blockOuput.getNumChannels(); channel++)
+    const auto numSamples = static_cast<int> (blockOuput.getNumSamples());
+
+    float* driveRamp = rampBuffer.getWritePointer(0);
+    float* wetRamp = rampBuffer.getWritePointer(1);
+    float* dryRamp = rampBuffer.getWritePointer(2);
+
+    const bool driveIsSmoothing = ParameterSmoothing::fillRamp(drive, driveRamp, numSamples);
+    float wetGain = 0.0f, dryGain = 0.0f;
+    const bool mixIsSmoothing = ParameterSmoothing::fillMixRamps(volume, mix, wetRamp, dryRamp, numSamples, wetGain, dryGain);
+
+    for (int channel = 0; channel < static_cast<int> (blockOuput.getNumChannels()); channel++)
     {
-        for (int sample = 0; sample < blockOuput.getNumSamples(); sample++)
+        float* data = blockOuput.getChannelPointer(static_cast<size_t> (channel));
+        float* cleanSig = dryBuffer.getWritePointer(channel);
+        auto& state = antialiasingStates[static_cast<size_t> (channel)];
+
+        juce::FloatVectorOperations::copy(cleanSig, data, numSamples);
+
+        // Input Gain
+        if (driveIsSmoothing)
+            juce::FloatVectorOperations::multiply(data, driveRamp, numSamples);
+        else
+            juce::FloatVectorOperations::multiply(data, drive.getTargetValue(), numSamples);
+
+        if constexpr (Shaper::usesCompressor)
         {
-            float in = blockOuput.getSample(channel, sample);
-            float cleanSig = in;
-
-            // Distortion Type
-            if (distortionType == 1 || distortionType == 2 || distortionType == 3 || distortionType == 4 || distortionType == 5)
-            {
-                // Input Gain (Not for Full wave and Half wave rectifier)
-                in *= drive;
-            }
-            float out = 0.0f;
-            if (distortionType == 1)
-            {
-                // Simple hard clipping
-                float threshold = 1.0f;
-                if (in > threshold)
-                    out = threshold;
-                else if (in < -threshold)
-                    out = -threshold;
-                else
-                    out = in;
-            }
-            else if (distortionType == 2)
-            {
-                // Soft clipping based on quadratic function
-                float threshold1 = 1.0f / 3.0f;
-                float threshold2 = 2.0f / 3.0f;
-                if (in > threshold2)
-                    out = 1.0f;
-                else if (in > threshold1)
-                    out = (3.0f - (2.0f - 3.0f * in) * (2.0f - 3.0f * in)) / 3.0f;
-                else if (in < -threshold2)
-                    out = -1.0f;
-                else if (in < -threshold1)
-                    out = -(3.0f - (2.0f + 3.0f * in) * (2.0f + 3.0f * in)) / 3.0f;
-                else
-                    out = 2.0f * in;
-            }
-            else if (distortionType == 3)
-            {
-                // Soft clipping based on exponential function
-                if (in > 0)
-                    out = 1.0f - expf(-in);
-                else
-                    out = -1.0f + expf(in);
-
-                out = out * 1.5f;
-            }
-            else if (distortionType == 4)
-            {
-                // ArcTan
-                out = (2.0f / juce::MathConstants<float>::pi) * atan(in);
-            }
-            else if (distortionType == 5)
-            {
-                // tubeIsh Distortion
-                out = compressor.processSample(channel, in);
-
-                out = juce::dsp::FastMathApproximations::tanh(out);
-                float x = out * 0.25;
-                float a = abs(x);
-                float x2 = x * x;
-                float y = 1 - 1 / (1 + a + x2 + 0.66422417311781 * x2 * a + 0.36483285408241 * x2 * x2);
-                if (x >= 0)
-                {
-                    out = y;
-                }
-                else
-                {
-                    out = -y;
-                }
-                out = out * 3.0f;
-            }
-            out = (((out * (mix / 100.0f)) + (cleanSig * (1.0f - (mix / 100.0f)))) * juce::Decibels::decibelsToGain(volume));
-
-            blockOuput.setSample(channel, sample, out);
+            for (int sample = 0; sample < numSamples; sample++)
+                data[sample] = compressor.processSample(channel, data[sample]);
+        }
+
+        if (activeAntialiasingOrder == 1)
+            WaveShapers::processFirstOrderADAA<Shaper>(data, numSamples, state);
+        else if (activeAntialiasingOrder == 2)
+            WaveShapers::processSecondOrderADAA<Shaper>(data, numSamples, state);
+        else
+            Shaper::process(data, numSamples);
+
+        if (activeAntialiasingOrder > 0)
+            WaveShapers::alignDrySignal(cleanSig, numSamples, activeAntialiasingOrder, state);
+
+        if (mixIsSmoothing)
+        {
+            juce::FloatVectorOperations::multiply(data, wetRamp, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(data, cleanSig, dryRamp, numSamples);
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply(data, wetGain, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(data, cleanSig, dryGain, numSamples);
         }
     }
     oversampling.processSamplesDown(block);
-}
\ No newline at end of file
+}
@@ -10,18 +10,73 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "WaveShapers.h"
+#include "../Utils/Parameters.h"
+#include "../Utils/QualityProfile.h"
 
 class Saturation
 {
 public:
     Saturation();
 
+    // Takes effect on the next prepare
+    void setQualityProfile(const QualityProfile& newProfile);
+
     void prepare(juce::dsp::ProcessSpec& spec);
-    void process(juce::dsp::AudioBlock<float>& block);
+    // silentInputSamples is how long the input has been silent (see
+    // SilenceDetector); once the silence before the block covers
+    // getSettleSamples() it is passed through without the oversampling
+    // round trip
+    void process(juce::dsp::AudioBlock<float>& block, juce::int64 silentInputSamples);
+
+    // Latency of the active oversampling and ADAA settings, in host samples
+    float getLatencyInSamples() const;
+
+    // Input silence needed before the output is silent too: the latency plus
+    // time for the oversampling filters to ring out
+    juce::int64 getSettleSamples() const;
+
+    // Targets for the smoothed parameters; mix in percent, volume in dB
+    void setDrive(float newDrive);
+    void setMix(float newMix);
+    void setVolume(float newVolume);
 
-    float distortionType{ 0 }, drive{ 0 }, mix{ 0 }, volume{ 0 };
+    float distortionType{ 0 };
+
+    // 0..3 for 1x, 2x, 4x, 8x; 0 = off, 1 = first order ADAA, 2 = second order ADAA
+    int oversamplingOrder{ 2 }, antialiasingOrder{ 0 };
 
 private:
-    juce::dsp::Oversampling<float> oversampling{ 2, 2, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false };
-    juce::dsp::Compressor<float> compressor;
-};
\ No newline at end of file
+    static constexpr int numOversamplingOrders = 4;
+
+    // Runs one distortion curve over the whole oversampled block
+    template <typename Shaper>
+    void processWithShaper(juce::dsp::AudioBlock<float>& block);
+
+    // Picks up oversamplingOrder and antialiasingOrder changes at block start
+    void updateProcessingMode();
+
+    // Clears the filter and smoothing state left over from before a sleep
+    void wakeUp();
+
+    // One oversampler and compressor per factor, all built in prepare so
+    // switching factor on the audio thread only has to reset state
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, numOversamplingOrders> oversamplers;
+    std::array<juce::dsp::Compressor<float>, numOversamplingOrders> compressors;
+    int activeOrder{ -1 }, activeAntialiasingOrder{ 0 };
+    bool isSleeping{ false };
+
+    static constexpr double ringOutSeconds = 0.01;
+
+    double sampleRate{ 48000 };
+    QualityProfile quality{ QualityProfile::realtime() };
+
+    ParameterSmoothing::Drive drive;
+    ParameterSmoothing::Mix mix;
+    ParameterSmoothing::Gain volume;
+
+    // Per-sample drive, wet and dry gains while a parameter is moving
+    juce::AudioBuffer<float> rampBuffer;
+    juce::AudioBuffer<float> dryBuffer;
+    std::vector<WaveShapers::AntialiasingState> antialiasingStates;
+};
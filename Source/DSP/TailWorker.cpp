@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    TailWorker.cpp
+    Created: 17 Oct 2026 9:48:30pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#include "TailWorker.h"
+
+TailWorker::TailWorker()
+    : juce::Thread("Convolution Tail")
+{
+    startRealtimeThread(juce::Thread::RealtimeOptions{});
+}
+
+TailWorker::~TailWorker()
+{
+    // Anything still queued belongs to engines that are already gone and
+    // released their jobs, so there is nothing left to run
+    stopThread(4000);
+}
+
+void TailWorker::post(Job& job)
+{
+    job.state.store(Job::queued, std::memory_order_release);
+
+    bool isQueued = false;
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 + scope.blockSize2 > 0)
+        {
+            job.numQueued.fetch_add(1, std::memory_order_relaxed);
+            queue[static_cast<size_t> (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = &job;
+            isQueued = true;
+        }
+    }
+
+    if (! isQueued)
+        tryRun(job);
+    else if (isSleeping.exchange(false))
+        notify();
+}
+
+void TailWorker::tryRun(Job& job)
+{
+    int expected = Job::queued;
+    if (job.state.compare_exchange_strong(expected, Job::running, std::memory_order_acq_rel))
+    {
+        job.run();
+        job.state.store(Job::done, std::memory_order_release);
+    }
+}
+
+void TailWorker::finish(Job& job)
+{
+    tryRun(job);
+
+    // The worker is part-way through it
+    while (job.state.load(std::memory_order_acquire) == Job::running)
+        juce::Thread::yield();
+}
+
+void TailWorker::release(Job& job)
+{
+    finish(job);
+
+    while (job.numQueued.load(std::memory_order_acquire) > 0)
+        juce::Thread::sleep(1);
+}
+
+void TailWorker::run()
+{
+    while (! threadShouldExit())
+    {
+        Job* job = nullptr;
+        {
+            const auto scope = fifo.read(1);
+            if (scope.blockSize1 + scope.blockSize2 > 0)
+                job = queue[static_cast<size_t> (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+        }
+
+        if (job == nullptr)
+        {
+            // Announced before the queue is checked again, so a post either
+            // lands in that check or sees the flag and signals
+            isSleeping.store(true);
+            if (fifo.getNumReady() == 0)
+                wait(100);
+
+            isSleeping.store(false);
+            continue;
+        }
+
+        // The audio thread may have got to it first, or it may be queued
+        // twice; either way the state says whether it still needs running
+        tryRun(*job);
+        job->numQueued.fetch_sub(1, std::memory_order_release);
+    }
+}
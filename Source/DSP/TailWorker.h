@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    TailWorker.h
+    Created: 17 Oct 2026 9:48:30pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A real-time priority thread that runs convolution frames a frame ahead of
+// when they are heard. The audio thread posts a job when a large partition
+// comes due and collects the result one frame later; if the worker hasn't
+// started it by then, the audio thread runs it itself, so a late worker
+// costs a spike but never a dropout.
+//
+// There is one producer (the owner's audio thread) and one consumer. post()
+// queues without locking, but waking a sleeping worker signals a
+// WaitableEvent, which takes that event's mutex; the worker only holds it
+// briefly around its own wait, and post() skips the signal while the worker
+// is awake. finish() can also spin, see below.
+class TailWorker : private juce::Thread
+{
+public:
+    struct Job
+    {
+        virtual ~Job() = default;
+        virtual void run() = 0;
+
+        enum State { idle, queued, running, done };
+        std::atomic<int> state{ idle };
+
+        // Entries the worker's queue still holds for this job
+        std::atomic<int> numQueued{ 0 };
+    };
+
+    TailWorker();
+    ~TailWorker() override;
+
+    // Audio thread. Runs the job in place if the queue is full.
+    void post(Job& job);
+
+    // Audio thread. Returns once the job's last post has finished, running it
+    // here if the worker hasn't picked it up yet. If the worker is part-way
+    // through it, yields until it is done: the result is needed this block,
+    // so the audio thread waits up to the rest of one job.
+    static void finish(Job& job);
+
+    // Blocks until the worker holds no reference to the job, so it can be
+    // destroyed. Not for the audio thread.
+    static void release(Job& job);
+
+private:
+    void run() override;
+
+    // Runs the job if nobody else has claimed it
+    static void tryRun(Job& job);
+
+    static constexpr int queueSize = 64;
+    juce::AbstractFifo fifo{ queueSize };
+    std::array<Job*, queueSize> queue{};
+
+    // Set by the worker before it waits, cleared by whichever side wakes it
+    std::atomic<bool> isSleeping{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TailWorker)
+};
@@ -3,38 +3,59 @@
 #include <limits>
 #include <JuceHeader.h>
 
-#include "NotchFilter.h"
-#include "PeakFilter.h"
-
-// Substitute EQ class alias here
- using EQ = PeakFilter;
-// using EQ = NotchFilter;
+#include "BiquadCascade.h"
+#include "BiquadDesigner.h"
+#include "../Utils/Parameters.h"
 
 class VocalBox
 {
 
 	size_t bufferChannel = 1, bufferNumOfSamples = 0;	// Buffer characteristics
-	NotchFilter baseFreqNotch;
-	std::vector<EQ*> peakSeries;
+
+	// Stage 0 notches out the fundamental; the rest cut the harmonics above it
+	BiquadCascade harmonicFilters;
+	double sampleRate = 44100;
+
+	// The pitch moves every block, so the stages are designed from tables
+	std::array<BiquadDesigner, BiquadCascade::maxStages> stageDesigners;
+	BiquadDesigner::Table notchTable, peakTable;
+	static constexpr float minTableFrequency = 20.0f;
+	static constexpr int tablePointsPerOctave = 96;
+
+	// Fades the filters in while the input is voiced and out while it isn't;
+	// fully out, they don't run at all
+	ParameterSmoothing::Mix voicing;
+	bool isBypassed = true;
+	double lastFrequency = 0;	// keeps the filters tuned while they fade out
+	juce::AudioBuffer<float> dryBuffer;
+	juce::AudioBuffer<float> rampBuffer;
+
+	static constexpr double voicedThreshold = 0.5;
+	static constexpr double fadeSeconds = 0.02;
+
+	static constexpr float notchQuality = 1.88f;
+	static constexpr float peakQuality = 15.0f;
+	static constexpr float peakGainDecibels = -30.0f;
 
 public:
 	// juce::dsp::ProcessSpec* spec;
 	VocalBox(){}
 
-	~VocalBox() {
-		peakSeries.clear();
-	}
-
 	void InitEQSeries(size_t steps, juce::dsp::ProcessSpec& spec) {
-		baseFreqNotch.prepare(spec);
-
-		for (size_t i = 0; i < steps - 1; ++i) {
-			EQ* new_eq = new EQ;
-			new_eq->prepare(spec);
-			new_eq->peakQuality = 15;
-			new_eq->peakGain = juce::Decibels::decibelsToGain(-30.0f);
-			peakSeries.push_back(new_eq);
-		}	
+		sampleRate = spec.sampleRate;
+		harmonicFilters.prepare(juce::jmin(static_cast<int>(steps), BiquadCascade::maxStages),
+		                        juce::jmin(static_cast<int>(spec.numChannels), BiquadCascade::maxChannels));
+
+		// Anything the tables miss, such as a peak right by Nyquist, is designed exactly
+		const auto maxTableFrequency = static_cast<float>(0.49 * sampleRate);
+		const auto peakGain = juce::Decibels::decibelsToGain(peakGainDecibels);
+		notchTable.prepare(BiquadDesigner::notch, sampleRate, 1.0f, minTableFrequency, maxTableFrequency,
+		                   tablePointsPerOctave, notchQuality, notchQuality, 1);
+		peakTable.prepare(BiquadDesigner::peak, sampleRate, peakGain, minTableFrequency, maxTableFrequency,
+		                  tablePointsPerOctave, peakQuality, peakQuality, 1);
+
+		for (size_t stage = 0; stage < stageDesigners.size(); ++stage)
+			stageDesigners[stage].setTable(stage == 0 ? &notchTable : &peakTable);
 	}
 
 	void InitAll(size_t harmonicPrecision, juce::dsp::ProcessSpec& spec) {
@@ -43,25 +64,74 @@ public:
 	
 	void ApplyEQ(juce::dsp::AudioBlock<float>& in_audioBlock, double& freq) {
 		if (freq <= 0) return;
-		baseFreqNotch.notchFrequency = freq;
-		baseFreqNotch.notchQuality = 1.88;
-		baseFreqNotch.process(in_audioBlock);
-		/**/
-		for (size_t i = 0; i < peakSeries.size(); ++i) {
-			peakSeries[i]->peakFrequency = freq * (i + 3) * 0.5;
-			if (peakSeries[i]->peakFrequency >= peakSeries[i]->peakSampleRate / 2) break;
-			peakSeries[i]->process(in_audioBlock);
+
+		const auto nyquist = sampleRate / 2;
+		const auto peakGain = juce::Decibels::decibelsToGain(peakGainDecibels);
+
+		// Stages are only rewritten when their design changed
+		if (stageDesigners[0].designNotch(sampleRate, static_cast<float>(freq), notchQuality))
+			harmonicFilters.setStage(0, stageDesigners[0].getCoefficients());
+
+		// Harmonics past Nyquist, and every stage after them, are dropped
+		int numStages = 1;
+		for (; numStages < harmonicFilters.getNumStages(); ++numStages) {
+			const auto peakFrequency = freq * (numStages + 2) * 0.5;
+			if (peakFrequency >= nyquist) break;
+			auto& designer = stageDesigners[static_cast<size_t>(numStages)];
+			if (designer.designPeak(sampleRate, static_cast<float>(peakFrequency), peakQuality, peakGain))
+				harmonicFilters.setStage(numStages, designer.getCoefficients());
 		}
-		
+		harmonicFilters.setNumActiveStages(numStages);
+
+		harmonicFilters.process(in_audioBlock);
 	}
 
 	void prepare(juce::dsp::ProcessSpec& in_spec, size_t harmonicPrecision) {
 		InitAll(harmonicPrecision, in_spec);
+
+		dryBuffer.setSize(static_cast<int>(in_spec.numChannels), static_cast<int>(in_spec.maximumBlockSize));
+		rampBuffer.setSize(2, static_cast<int>(in_spec.maximumBlockSize));
+		voicing.reset(in_spec.sampleRate, fadeSeconds);
+		voicing.setCurrentAndTargetValue(0.0f);
+		isBypassed = true;
 	}
 
-	void process(juce::dsp::AudioBlock<float>& in_audioBlock, double& frequency) {
-		if (frequency < 3000 && frequency > 0) {
-			ApplyEQ(in_audioBlock, frequency);
+	// voicedProbability is the pitch tracker's confidence in frequency
+	void process(juce::dsp::AudioBlock<float>& in_audioBlock, double frequency, double voicedProbability) {
+		const bool isVoiced = frequency < 3000 && frequency > 0 && voicedProbability >= voicedThreshold;
+		if (isVoiced) lastFrequency = frequency;
+		voicing.setTargetValue(isVoiced ? 1.0f : 0.0f);
+
+		const auto numSamples = static_cast<int>(in_audioBlock.getNumSamples());
+		if (! voicing.isSmoothing() && voicing.getTargetValue() == 0.0f) {
+			isBypassed = true;
+			return;
+		}
+
+		// Whatever the filters held is from the last voiced stretch
+		if (isBypassed) {
+			harmonicFilters.reset();
+			isBypassed = false;
+		}
+
+		float* wetRamp = rampBuffer.getWritePointer(0);
+		float* dryRamp = rampBuffer.getWritePointer(1);
+		float wetGain = 1.0f, dryGain = 0.0f;
+		if (! ParameterSmoothing::fillMixRamps(voicing, wetRamp, dryRamp, numSamples, wetGain, dryGain)) {
+			ApplyEQ(in_audioBlock, lastFrequency);
+			return;
+		}
+
+		const auto numChannels = juce::jmin(static_cast<int>(in_audioBlock.getNumChannels()), dryBuffer.getNumChannels());
+		for (int channel = 0; channel < numChannels; ++channel)
+			dryBuffer.copyFrom(channel, 0, in_audioBlock.getChannelPointer(static_cast<size_t>(channel)), numSamples);
+
+		ApplyEQ(in_audioBlock, lastFrequency);
+
+		for (int channel = 0; channel < numChannels; ++channel) {
+			float* data = in_audioBlock.getChannelPointer(static_cast<size_t>(channel));
+			juce::FloatVectorOperations::multiply(data, wetRamp, numSamples);
+			juce::FloatVectorOperations::addWithMultiply(data, dryBuffer.getReadPointer(channel), dryRamp, numSamples);
 		}
 	}
 };
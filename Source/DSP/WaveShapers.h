@@ -0,0 +1,434 @@
+/*
+  ==============================================================================
+
+    WaveShapers.h
+    Created: 17 Oct 2026 10:05:12am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Branch-free distortion curves used by Saturation. Each kernel works in place
+// on one contiguous channel and is picked once per block, so the inner loops
+// never look at distortionType.
+//
+// Every kernel also carries its curve and first two antiderivatives in double
+// precision for the antiderivative anti-aliasing (ADAA) paths at the bottom.
+namespace WaveShapers
+{
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    inline double sign(double x) noexcept
+    {
+        return x < 0.0 ? -1.0 : 1.0;
+    }
+
+    // Runs Kernel::apply over the aligned body of the channel with SIMDRegister,
+    // and over the unaligned head and tail one sample at a time.
+    template <typename Kernel>
+    inline void processVectorised(float* data, int numSamples) noexcept
+    {
+        constexpr auto width = static_cast<int> (SIMDFloat::SIMDNumElements);
+
+        auto* end = data + numSamples;
+        auto* alignedStart = juce::jmin(SIMDFloat::getNextSIMDAlignedPtr(data), end);
+
+        for (; data < alignedStart; ++data)
+            *data = Kernel::apply(SIMDFloat::expand(*data)).get(0);
+
+        for (; data + width <= end; data += width)
+            Kernel::apply(SIMDFloat::fromRawArray(data)).copyToRawArray(data);
+
+        for (; data < end; ++data)
+            *data = Kernel::apply(SIMDFloat::expand(*data)).get(0);
+    }
+
+    inline SIMDFloat absolute(SIMDFloat x) noexcept
+    {
+        return SIMDFloat::max(x, x * -1.0f);
+    }
+
+    // Gives magnitude the sign of x
+    inline SIMDFloat withSignOf(SIMDFloat magnitude, SIMDFloat x) noexcept
+    {
+        const auto negative = SIMDFloat::lessThan(x, SIMDFloat::expand(0.0f));
+        return (magnitude & ~negative) + ((magnitude * -1.0f) & negative);
+    }
+
+    // e^-a for a >= 0: a short Taylor series of e^(-a/64), squared six times.
+    // Inputs are clamped at 16, where the result is already below 1e-7.
+    inline SIMDFloat expNegative(SIMDFloat a) noexcept
+    {
+        const auto t = SIMDFloat::min(a, SIMDFloat::expand(16.0f)) * (-1.0f / 64.0f);
+
+        auto y = t * (1.0f / 120.0f) + 1.0f / 24.0f;
+        y = y * t + 1.0f / 6.0f;
+        y = y * t + 0.5f;
+        y = y * t + 1.0f;
+        y = y * t + 1.0f;
+
+        for (int i = 0; i < 6; ++i)
+            y = y * y;
+
+        return y;
+    }
+
+    // 1 / d for d in [1, 2]: linear minimax seed and three Newton steps
+    inline SIMDFloat reciprocalOneToTwo(SIMDFloat d) noexcept
+    {
+        auto r = d * (-8.0f / 17.0f) + 24.0f / 17.0f;
+
+        for (int i = 0; i < 3; ++i)
+            r = r * (SIMDFloat::expand(2.0f) - d * r);
+
+        return r;
+    }
+
+    // Simple hard clipping
+    struct HardClip
+    {
+        static constexpr bool usesCompressor = false;
+
+        static void process(float* data, int numSamples) noexcept
+        {
+            juce::FloatVectorOperations::clip(data, data, -1.0f, 1.0f, numSamples);
+        }
+
+        static double curve(double x) noexcept
+        {
+            return juce::jlimit(-1.0, 1.0, x);
+        }
+
+        static double antiderivative1(double x) noexcept
+        {
+            const double a = std::abs(x);
+            return a <= 1.0 ? 0.5 * x * x : a - 0.5;
+        }
+
+        static double antiderivative2(double x) noexcept
+        {
+            const double a = std::abs(x);
+            return a <= 1.0 ? x * x * x / 6.0 : sign(x) * (0.5 * x * x + 1.0 / 6.0) - 0.5 * x;
+        }
+    };
+
+    // Soft clipping based on quadratic function
+    struct QuadraticSoftClip
+    {
+        static constexpr bool usesCompressor = false;
+
+        static SIMDFloat apply(SIMDFloat x) noexcept
+        {
+            const auto a = SIMDFloat::min(absolute(x), SIMDFloat::expand(2.0f / 3.0f));
+            const auto d = SIMDFloat::expand(2.0f) - a * 3.0f;
+
+            const auto linear = a * 2.0f;
+            const auto knee = SIMDFloat::expand(1.0f) - d * d * (1.0f / 3.0f);
+            const auto inLinearRegion = SIMDFloat::lessThanOrEqual(a, SIMDFloat::expand(1.0f / 3.0f));
+
+            return withSignOf((linear & inLinearRegion) + (knee & ~inLinearRegion), x);
+        }
+
+        static void process(float* data, int numSamples) noexcept
+        {
+            processVectorised<QuadraticSoftClip>(data, numSamples);
+        }
+
+        static double curve(double x) noexcept
+        {
+            const double a = std::abs(x);
+
+            if (a <= 1.0 / 3.0)
+                return 2.0 * x;
+            if (a <= 2.0 / 3.0)
+                return sign(x) * (1.0 - (2.0 - 3.0 * a) * (2.0 - 3.0 * a) / 3.0);
+            return sign(x);
+        }
+
+        static double antiderivative1(double x) noexcept
+        {
+            const double a = std::abs(x);
+
+            if (a <= 1.0 / 3.0)
+                return a * a;
+            if (a <= 2.0 / 3.0)
+                return 1.0 / 9.0 + (a - 1.0 / 3.0) + (std::pow(2.0 - 3.0 * a, 3.0) - 1.0) / 27.0;
+            return 11.0 / 27.0 + (a - 2.0 / 3.0);
+        }
+
+        static double antiderivative2(double x) noexcept
+        {
+            const double a = std::abs(x);
+
+            if (a <= 1.0 / 3.0)
+                return x * x * x / 3.0;
+            if (a <= 2.0 / 3.0)
+                return sign(x) * (1.0 / 81.0 - 7.0 / 27.0 * (a - 1.0 / 3.0) + 0.5 * (a * a - 1.0 / 9.0)
+                                  - (std::pow(2.0 - 3.0 * a, 4.0) - 1.0) / 324.0);
+
+            const double b = a - 2.0 / 3.0;
+            return sign(x) * (31.0 / 324.0 + 11.0 / 27.0 * b + 0.5 * b * b);
+        }
+    };
+
+    // Soft clipping based on exponential function
+    struct Exponential
+    {
+        static constexpr bool usesCompressor = false;
+
+        static SIMDFloat apply(SIMDFloat x) noexcept
+        {
+            const auto y = (SIMDFloat::expand(1.0f) - expNegative(absolute(x))) * 1.5f;
+            return withSignOf(y, x);
+        }
+
+        static void process(float* data, int numSamples) noexcept
+        {
+            processVectorised<Exponential>(data, numSamples);
+        }
+
+        static double curve(double x) noexcept
+        {
+            return -1.5 * sign(x) * std::expm1(-std::abs(x));
+        }
+
+        static double antiderivative1(double x) noexcept
+        {
+            const double a = std::abs(x);
+            return 1.5 * (a + std::expm1(-a));
+        }
+
+        static double antiderivative2(double x) noexcept
+        {
+            const double a = std::abs(x);
+            return 1.5 * sign(x) * (0.5 * a * a - a - std::expm1(-a));
+        }
+    };
+
+    // ArcTan. SIMDRegister has no division, so this one stays a plain loop that
+    // the compiler can hand to its vector maths library.
+    struct ArcTan
+    {
+        static constexpr bool usesCompressor = false;
+
+        static void process(float* data, int numSamples) noexcept
+        {
+            constexpr auto scale = 2.0f / juce::MathConstants<float>::pi;
+
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = scale * std::atan(data[i]);
+        }
+
+        static double curve(double x) noexcept
+        {
+            return 2.0 / juce::MathConstants<double>::pi * std::atan(x);
+        }
+
+        static double antiderivative1(double x) noexcept
+        {
+            return 2.0 / juce::MathConstants<double>::pi * (x * std::atan(x) - 0.5 * std::log1p(x * x));
+        }
+
+        static double antiderivative2(double x) noexcept
+        {
+            return 2.0 / juce::MathConstants<double>::pi
+                 * (0.5 * (x * x - 1.0) * std::atan(x) + 0.5 * x - 0.5 * x * std::log1p(x * x));
+        }
+    };
+
+    // tubeIsh Distortion. Expects the signal to have been through Saturation's
+    // compressor already; tanh is built from expNegative, and both divisions
+    // have denominators in [1, 2] so they can use reciprocalOneToTwo.
+    struct Tube
+    {
+        static constexpr bool usesCompressor = true;
+
+        static SIMDFloat apply(SIMDFloat x) noexcept
+        {
+            const auto e = expNegative(absolute(x) * 2.0f);
+            const auto t = (SIMDFloat::expand(1.0f) - e) * reciprocalOneToTwo(e + 1.0f);
+
+            const auto a = t * 0.25f;
+            const auto a2 = a * a;
+            const auto d = a + a2 + (a2 * a * 0.66422417311781f) + (a2 * a2 * 0.36483285408241f) + 1.0f;
+            const auto y = (SIMDFloat::expand(1.0f) - reciprocalOneToTwo(d)) * 3.0f;
+
+            return withSignOf(y, x);
+        }
+
+        static void process(float* data, int numSamples) noexcept
+        {
+            processVectorised<Tube>(data, numSamples);
+        }
+
+        static double curve(double x) noexcept
+        {
+            const double a = 0.25 * std::tanh(std::abs(x));
+            const double a2 = a * a;
+            return 3.0 * sign(x) * (1.0 - 1.0 / (1.0 + a + a2 + 0.66422417311781 * a2 * a + 0.36483285408241 * a2 * a2));
+        }
+
+        // The tube curve has no closed-form antiderivatives, so they are
+        // tabulated once and read back with cubic Hermite interpolation.
+        // Past the end of the table the curve is flat to within 1e-6.
+        class AntiderivativeTable
+        {
+        public:
+            AntiderivativeTable()
+            {
+                for (int i = 0; i <= size; ++i)
+                    values[i] = curve(i * step);
+
+                // F1 by Simpson's rule on each interval, F2 by integrating the
+                // Hermite cubic through F1 exactly
+                first[0] = 0.0;
+                second[0] = 0.0;
+                for (int i = 0; i < size; ++i)
+                {
+                    const double x = i * step;
+                    first[i + 1] = first[i] + step / 6.0 * (values[i] + 4.0 * curve(x + 0.5 * step) + values[i + 1]);
+                    second[i + 1] = second[i] + 0.5 * step * (first[i] + first[i + 1]) + step * step / 12.0 * (values[i] - values[i + 1]);
+                }
+            }
+
+            double antiderivative1(double x) const noexcept
+            {
+                // F1 is even
+                const double a = std::abs(x);
+                if (a >= range)
+                    return first[size] + values[size] * (a - range);
+                return interpolate(first, values, a);
+            }
+
+            double antiderivative2(double x) const noexcept
+            {
+                // F2 is odd
+                const double a = std::abs(x);
+                if (a >= range)
+                {
+                    const double d = a - range;
+                    return sign(x) * (second[size] + first[size] * d + 0.5 * values[size] * d * d);
+                }
+                return sign(x) * interpolate(second, first, a);
+            }
+
+        private:
+            static constexpr int size = 4096;
+            static constexpr double range = 8.0;
+            static constexpr double step = range / size;
+
+            static double interpolate(const std::array<double, size + 1>& y, const std::array<double, size + 1>& dydx, double a) noexcept
+            {
+                const int i = juce::jmin(static_cast<int> (a / step), size - 1);
+                const double t = a / step - i;
+                const double t2 = t * t;
+                const double t3 = t2 * t;
+
+                return (2.0 * t3 - 3.0 * t2 + 1.0) * y[i] + (t3 - 2.0 * t2 + t) * step * dydx[i]
+                     + (-2.0 * t3 + 3.0 * t2) * y[i + 1] + (t3 - t2) * step * dydx[i + 1];
+            }
+
+            std::array<double, size + 1> values, first, second;
+        };
+
+        // Built on first use; Saturation::prepare touches it so that never
+        // happens on the audio thread
+        static const AntiderivativeTable& getAntiderivativeTable()
+        {
+            static const AntiderivativeTable table;
+            return table;
+        }
+
+        static double antiderivative1(double x) noexcept
+        {
+            return getAntiderivativeTable().antiderivative1(x);
+        }
+
+        static double antiderivative2(double x) noexcept
+        {
+            return getAntiderivativeTable().antiderivative2(x);
+        }
+    };
+
+    //==============================================================================
+    // Per-channel history for the ADAA paths. The dry history keeps the clean
+    // signal aligned with the half (first order) or whole (second order) sample
+    // of delay that ADAA adds to the wet signal.
+    struct AntialiasingState
+    {
+        double x1 = 0, x2 = 0;
+        double ad1x1 = 0, ad2x1 = 0;
+        double d2 = 0;
+        float lastDry = 0;
+    };
+
+    // Below this input step the difference quotients are ill-conditioned and
+    // the limits are used instead
+    constexpr double adaaTolerance = 1.0e-5;
+
+    template <typename Shaper>
+    void processFirstOrderADAA(float* data, int numSamples, AntialiasingState& state) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double x = data[i];
+            const double ad1 = Shaper::antiderivative1(x);
+            const double delta = x - state.x1;
+
+            data[i] = static_cast<float> (std::abs(delta) < adaaTolerance ? Shaper::curve(0.5 * (x + state.x1))
+                                                                           : (ad1 - state.ad1x1) / delta);
+            state.x1 = x;
+            state.ad1x1 = ad1;
+        }
+    }
+
+    template <typename Shaper>
+    void processSecondOrderADAA(float* data, int numSamples, AntialiasingState& state) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double x = data[i];
+            const double ad2 = Shaper::antiderivative2(x);
+            const double delta1 = x - state.x1;
+
+            const double d1 = std::abs(delta1) < adaaTolerance ? Shaper::antiderivative1(0.5 * (x + state.x1))
+                                                               : (ad2 - state.ad2x1) / delta1;
+            const double delta2 = x - state.x2;
+            double y;
+
+            if (std::abs(delta2) >= adaaTolerance)
+            {
+                y = 2.0 * (d1 - state.d2) / delta2;
+            }
+            else
+            {
+                const double xBar = 0.5 * (x + state.x2);
+                const double delta = xBar - state.x1;
+
+                y = std::abs(delta) < adaaTolerance
+                  ? Shaper::curve(0.5 * (xBar + state.x1))
+                  : 2.0 / delta * (Shaper::antiderivative1(xBar) + (state.ad2x1 - Shaper::antiderivative2(xBar)) / delta);
+            }
+
+            data[i] = static_cast<float> (y);
+            state.x2 = state.x1;
+            state.x1 = x;
+            state.ad2x1 = ad2;
+            state.d2 = d1;
+        }
+    }
+
+    // Delays the clean signal by the same amount as the matching ADAA order
+    inline void alignDrySignal(float* data, int numSamples, int antialiasingOrder, AntialiasingState& state) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float in = data[i];
+            data[i] = antialiasingOrder == 1 ? 0.5f * (in + state.lastDry) : state.lastDry;
+            state.lastDry = in;
+        }
+    }
+}
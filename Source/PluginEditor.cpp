@@ -22,9 +22,6 @@ BraveLvkaiAudioProcessorEditor::BraveLvkaiAudioProcessorEditor (BraveLvkaiAudioP
     setSize (800, 400);
     juce::LookAndFeel::setDefaultLookAndFeel(&customStyle);
 
-    // set AudioFormatManager for reading IR file
-    formatManager.registerBasicFormats();
-
     addAndMakeVisible(openIRFileButton);
     openIRFileButton.setButtonText("Open IR File...");
     openIRFileButton.onClick = [this] { openButtonClicked(); };
@@ -53,10 +50,36 @@ BraveLvkaiAudioProcessorEditor::BraveLvkaiAudioProcessorEditor (BraveLvkaiAudioP
     createSlider(revDryWetSlider, " %");
     createLabel(revDryWetLabel, "", &revDryWetSlider);
     revDryWetSliderAttachment = std::make_unique<APVTS::SliderAttachment>(audioProcessor.apvts, "RevDryWet", revDryWetSlider);
+    addAndMakeVisible(reverseButton);
+    reverseButton.setButtonText("Reverse");
+    reverseButtonAttachment = std::make_unique<APVTS::ButtonAttachment>(audioProcessor.apvts, "IRReverse", reverseButton);
+
+    addAndMakeVisible(midiOutputButton);
+    midiOutputButton.setButtonText("MIDI Out");
+    midiOutputButtonAttachment = std::make_unique<APVTS::ButtonAttachment>(audioProcessor.apvts, "MidiOutput", midiOutputButton);
+    createSlider(decayTimeSlider, " %");
+    createLabel(decayTimeLabel, "Decay", &decayTimeSlider);
+    decayTimeSliderAttachment = std::make_unique<APVTS::SliderAttachment>(audioProcessor.apvts, "IRDecay", decayTimeSlider);
+    createSlider(preDelaySlider, " ms");
+    createLabel(preDelayLabel, "PreDelay", &preDelaySlider);
+    preDelaySliderAttachment = std::make_unique<APVTS::SliderAttachment>(audioProcessor.apvts, "IRPreDelay", preDelaySlider);
+
+    // IRs load on a background thread; the convolution tells us when one is in
+    audioProcessor.convolution.addChangeListener(this);
+    if (audioProcessor.convolution.getCurrentIRSize() > 0)
+    {
+        irFileLabel.setText(audioProcessor.convolution.getImpulseResponseFile().getFileName(), juce::dontSendNotification);
+        updateWaveform();
+        enableIRParameters = true;
+    }
+    reverseButton.setEnabled(enableIRParameters);
+    decayTimeSlider.setEnabled(enableIRParameters);
+    preDelaySlider.setEnabled(enableIRParameters);
 }
 
 BraveLvkaiAudioProcessorEditor::~BraveLvkaiAudioProcessorEditor()
 {
+    audioProcessor.convolution.removeChangeListener(this);
 }
 
 //==============================================================================
@@ -80,26 +103,12 @@ void BraveLvkaiAudioProcessorEditor::paint (juce::Graphics& g)
         const int waveformHeight = 100;
 
         juce::Path waveformPath;
-        waveformValues.clear();
         waveformPath.startNewSubPath(15, waveformHeight + 60);
 
-        auto buffer = audioProcessor.convolution.getModifiedIR();
-        if (buffer.getNumSamples() < 1)
-        {
-            buffer = audioProcessor.convolution.getOriginalIR();
-        }
-        const float waveformResolution = 1024.0f;
-        const int ratio = static_cast<int>(buffer.getNumSamples() / waveformResolution);
-
-        auto bufferPointer = buffer.getReadPointer(0);
-        for (int sample = 0; sample < buffer.getNumSamples(); sample += ratio)
-        {
-            waveformValues.push_back(juce::Decibels::gainToDecibels<float>(std::fabsf(bufferPointer[sample]), -72.0f));
-        }
         for (int xPos = 0; xPos < waveformValues.size(); ++xPos)
         {
             auto yPos = juce::jmap<float>(waveformValues[xPos], -72.0f, 0.0f, waveformHeight + 110, 100);
-            waveformPath.lineTo(15 + xPos / waveformResolution * waveformWidth, yPos);
+            waveformPath.lineTo(15 + xPos / static_cast<float>(waveformValues.size()) * waveformWidth, yPos);
         }
 
         g.strokePath(waveformPath, juce::PathStrokeType(1.0f));
@@ -120,6 +129,9 @@ void BraveLvkaiAudioProcessorEditor::resized()
     irFileLabel.setBounds(leftRightMargin + 30, topBottomMargin + 85, dialWidth * 3, 20);
 
     revDryWetSlider.setBounds(leftRightMargin + dialWidth - 6, getHeight() - topBottomMargin - dialHeight, dialWidth, dialHeight);
+    preDelaySlider.setBounds(leftRightMargin - 6, getHeight() - topBottomMargin - dialHeight, dialWidth, dialHeight);
+    decayTimeSlider.setBounds(leftRightMargin + dialWidth * 2 - 6, getHeight() - topBottomMargin - dialHeight, dialWidth, dialHeight);
+    reverseButton.setBounds(leftRightMargin + 27, topBottomMargin + 200, dialWidth, 20);
 
     /*highPassFreqSlider.setBounds(getWidth() - leftRightMargin - dialWidth * 3, getHeight() - 3 * topBottomMargin - 2 * dialHeight, dialWidth, dialHeight);
     lowPassFreqSlider.setBounds(getWidth() - leftRightMargin - dialWidth * 2, getHeight() - 3 * topBottomMargin - 2 * dialHeight, dialWidth, dialHeight);*/
@@ -129,6 +141,7 @@ void BraveLvkaiAudioProcessorEditor::resized()
     distortionTypeSlider.setBounds(getWidth() - leftRightMargin - dialWidth, getHeight() - topBottomMargin - dialHeight, dialWidth, dialHeight);
 
     freqVisual.setBounds(280, 100, 250, 20);
+    midiOutputButton.setBounds(280, 125, 100, 20);
 }
 
 void BraveLvkaiAudioProcessorEditor::timerCallback()
@@ -136,6 +149,29 @@ void BraveLvkaiAudioProcessorEditor::timerCallback()
 	freqVisual.repaint();
 }
 
+void BraveLvkaiAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    irFileLabel.setText(audioProcessor.convolution.getImpulseResponseFile().getFileName(), juce::dontSendNotification);
+    updateWaveform();
+
+    enableIRParameters = true;
+    reverseButton.setEnabled(enableIRParameters);
+    decayTimeSlider.setEnabled(enableIRParameters);
+    preDelaySlider.setEnabled(enableIRParameters);
+    repaint();
+}
+
+void BraveLvkaiAudioProcessorEditor::updateWaveform()
+{
+    // Worked out once per IR (or edit) rather than on every paint; the
+    // convolution already reduces it to one peak per slice
+    waveformValues = audioProcessor.convolution.getWaveform();
+    for (auto& value : waveformValues)
+        value = juce::Decibels::gainToDecibels<float>(value, -72.0f);
+
+    shouldPaintWaveform = true;
+}
+
 void BraveLvkaiAudioProcessorEditor::openButtonClicked()
 {
     fileChooser = std::make_unique<juce::FileChooser>(
@@ -151,19 +187,9 @@ void BraveLvkaiAudioProcessorEditor::openButtonClicked()
             irFileLabel.setText(file.getFileName(), juce::dontSendNotification);
             irFileLabel.repaint();
 
-            auto* reader = formatManager.createReaderFor(file);
-            if (reader != nullptr)
-            {
-                audioProcessor.convolution.setIRBufferSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
-                reader->read(&audioProcessor.convolution.getOriginalIR(), 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
-                audioProcessor.convolution.loadImpulseResponse();
-
-                shouldPaintWaveform = true;
-                enableIRParameters = true;
-                //reverseButton.setEnabled(enableIRParameters);
-                //decayTimeSlider.setEnabled(enableIRParameters);
-                repaint();
-            }
+            // Decoded and partitioned off this thread; changeListenerCallback
+            // picks it up once it is in
+            audioProcessor.convolution.loadImpulseResponse(file);
         }
     });
 }
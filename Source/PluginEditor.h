@@ -18,7 +18,7 @@
 //==============================================================================
 /**
 */
-class BraveLvkaiAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Timer
+class BraveLvkaiAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Timer, private juce::ChangeListener
 {
 public:
     BraveLvkaiAudioProcessorEditor (BraveLvkaiAudioProcessor&);
@@ -28,6 +28,7 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     void timerCallback() override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -35,7 +36,6 @@ private:
     BraveLvkaiAudioProcessor& audioProcessor;
 
     juce::CustomStyle customStyle;
-    juce::AudioFormatManager formatManager;
     std::unique_ptr<juce::FileChooser> fileChooser;
 
     std::vector<float> waveformValues;
@@ -68,8 +68,20 @@ private:
     juce::Slider revDryWetSlider;
     juce::Label revDryWetLabel;
     std::unique_ptr<APVTS::SliderAttachment> revDryWetSliderAttachment;
+    juce::ToggleButton reverseButton;
+    std::unique_ptr<APVTS::ButtonAttachment> reverseButtonAttachment;
+
+    juce::ToggleButton midiOutputButton;
+    std::unique_ptr<APVTS::ButtonAttachment> midiOutputButtonAttachment;
+    juce::Slider decayTimeSlider;
+    juce::Label decayTimeLabel;
+    std::unique_ptr<APVTS::SliderAttachment> decayTimeSliderAttachment;
+    juce::Slider preDelaySlider;
+    juce::Label preDelayLabel;
+    std::unique_ptr<APVTS::SliderAttachment> preDelaySliderAttachment;
 
     void openButtonClicked();
+    void updateWaveform();
     void createSlider(juce::Slider& slider, juce::String textValueSuffix);
     void createLabel(juce::Label& label, juce::String text,
         juce::Component* slider);
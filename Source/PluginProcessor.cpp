@@ -28,7 +28,6 @@ BraveLvkaiAudioProcessor::BraveLvkaiAudioProcessor()
 
 BraveLvkaiAudioProcessor::~BraveLvkaiAudioProcessor()
 {
-    if(pitchDetectionBuffer != nullptr) delete[] pitchDetectionBuffer;
 }
 
 //==============================================================================
@@ -66,7 +65,7 @@ bool BraveLvkaiAudioProcessor::isMidiEffect() const
 
 double BraveLvkaiAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return convolution.getTailLengthSeconds();
 }
 
 int BraveLvkaiAudioProcessor::getNumPrograms()
@@ -100,14 +99,33 @@ void BraveLvkaiAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
     spec.maximumBlockSize = samplesPerBlock;
     spec.sampleRate = sampleRate;
     spec.numChannels = getTotalNumOutputChannels();
+
+    // Offline bounces get the expensive settings
+    const auto quality = QualityProfile::forRenderMode(isNonRealtime());
+    saturation.setQualityProfile(quality);
+    convolution.setQualityProfile(quality);
+
+    saturation.distortionType = params.distortionType->load();
+    saturation.setDrive(params.drive->load());
+    saturation.setMix(params.satDryWet->load());
+    saturation.setVolume(params.volume->load());
+    saturation.oversamplingOrder = static_cast<int> (params.oversampling->load());
+    saturation.antialiasingOrder = static_cast<int> (params.antialiasing->load());
     saturation.prepare(spec);
+    convolution.setMix(params.revDryWet->load());
+    reportedLatency = juce::roundToInt(saturation.getLatencyInSamples());
+    setLatencySamples(reportedLatency);
+    updateIREdits();
     convolution.prepare(spec);
-    // pitchDetectionBuffer.clear();
-    pitchDetectionBuffer = new float[PITCH_BUFFER_SIZE * 2] {0};
-    yin.prepare(spec);
-    yin.SetBufferSize(PITCH_BUFFER_SIZE);
+    inputSilence.reset();
+
+    // The window covers the same time at any rate; offline, the analysis runs
+    // in step with the bounce
+    const int pitchWindow = juce::nextPowerOfTwo(juce::roundToInt(PITCH_BUFFER_SIZE * sampleRate / 48000.0));
+    pitchAnalyser.setAlgorithm(static_cast<int> (params.pitchAlgorithm->load()));
+    pitchAnalyser.prepare(sampleRate, pitchWindow, juce::jmin(quality.pitchHopSize, pitchWindow), isNonRealtime());
+    pitchToMidi.prepare(sampleRate);
     vocalBox.prepare(spec, 10);
-    
 }
 
 void BraveLvkaiAudioProcessor::releaseResources()
@@ -148,85 +166,80 @@ void BraveLvkaiAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-    static double tempFreq;
-    static bool ifFirstLoad = true;
-    static juce::AudioBuffer<float> secondaryBuffer;
-
     //define parameters in relation to the audio processor value tree state
-    float highPassFreq = *apvts.getRawParameterValue("HighPassFreq");
-    float lowPassFreq = *apvts.getRawParameterValue("LowPassFreq");
-    float drive = *apvts.getRawParameterValue("Drive");
-    float satDryWet = *apvts.getRawParameterValue("SatDryWet");
-    float volume = *apvts.getRawParameterValue("Volume");
-    float distortionType = *apvts.getRawParameterValue("DistortionType");
-    float revDryWet = *apvts.getRawParameterValue("RevDryWet");
-    static size_t sampleCounter = 0;
+    float drive = params.drive->load();
+    float satDryWet = params.satDryWet->load();
+    float volume = params.volume->load();
+    float distortionType = params.distortionType->load();
+    float revDryWet = params.revDryWet->load();
+    float oversampling = params.oversampling->load();
+    float antialiasing = params.antialiasing->load();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // if (ifFirstLoad) prevBuffer.makeCopyOf(buffer);
-
-    auto* sample = buffer.getReadPointer(0);
-
     juce::dsp::AudioBlock<float> block(buffer);
+    inputSilence.process(block);
 
-    //secondaryBuffer.makeCopyOf(buffer);
+    // The analysis thread does the work; this is just a copy
+    pitchAnalyser.setAlgorithm(static_cast<int> (params.pitchAlgorithm->load()));
+    pitchAnalyser.pushSamples(buffer.getReadPointer(0), buffer.getNumSamples());
 
-    //for (int i = 0; i < buffer.getNumSamples(); i++)
-    //{
-    //    if (ifFirstLoad) {
-    //        if (sampleCounter < PITCH_BUFFER_SIZE * 2)
-    //        {
-    //            pitchDetectionBuffer[sampleCounter] = sample[i];
-    //            sampleCounter++;
-    //        }
-    //        else
-    //        {
-    //            frequency = yin.Pitch(pitchDetectionBuffer);
-    //            sampleCounter = 0;
-    //            ifFirstLoad = false;
-    //        }
-    //    }
-    //    else {
-    //        if (sampleCounter < PITCH_BUFFER_SIZE)
-    //        {
-    //            if (sampleCounter == 0) {
-    //                // Shift data
-    //                for (size_t j = 0; j < PITCH_BUFFER_SIZE; ++j) {
-    //                    pitchDetectionBuffer[j] = pitchDetectionBuffer[j + PITCH_BUFFER_SIZE];
-    //                }
-    //            }
-    //            pitchDetectionBuffer[sampleCounter + PITCH_BUFFER_SIZE] = sample[i];
-    //            sampleCounter++;
-    //        }
-    //        else
-    //        {
-    //            frequency = yin.Pitch(pitchDetectionBuffer);
-    //            sampleCounter = 0;
-    //        }
-    //    }
-    //}
+    if (params.midiOutput->load() >= 0.5f)
+    {
+        pitchToMidi.process(buffer.getReadPointer(0), buffer.getNumSamples(), pitchAnalyser.getEstimate(), midiMessages);
+    }
+    else
+    {
+        pitchToMidi.stop(midiMessages, 0);
+        pitchToMidi.skip(buffer.getNumSamples());
+    }
 
-    //vocalBox.process(block, frequency);
-    
-    //block -= secondaryBuffer;
+    // Breaths, consonants and noise don't get the filters
+    const auto estimate = pitchAnalyser.getCurrentEstimate();
+    vocalBox.process(block, estimate.frequency, estimate.voicedProbability);
 
     saturation.distortionType = distortionType;
-    saturation.drive = drive;
-    saturation.mix = satDryWet;
-    saturation.volume = volume;
-    saturation.process(block);
+    saturation.setDrive(drive);
+    saturation.setMix(satDryWet);
+    saturation.setVolume(volume);
+    saturation.oversamplingOrder = static_cast<int> (oversampling);
+    saturation.antialiasingOrder = static_cast<int> (antialiasing);
+    saturation.process(block, inputSilence.getSilentSamples());
+    updateLatency();
 
     int caonima = convolution.getCurrentIRSize();
 
     //if (convolution.getCurrentIRSize() != 1)
     //{
-        convolution.mix = revDryWet;
-        convolution.process(block);
+        convolution.setMix(revDryWet);
+        updateIREdits();
+        // The saturation's output goes quiet a settle time after its input
+        convolution.process(block, inputSilence.getSilentSamples() - saturation.getSettleSamples());
     //}
 }
 
+void BraveLvkaiAudioProcessor::updateLatency()
+{
+    const int latency = juce::roundToInt(saturation.getLatencyInSamples());
+    if (reportedLatency.exchange(latency) != latency)
+        triggerAsyncUpdate();
+}
+
+void BraveLvkaiAudioProcessor::updateIREdits()
+{
+    IREdits edits;
+    edits.reverse = params.irReverse->load() >= 0.5f;
+    edits.decay = params.irDecay->load() / 100.0f;
+    edits.preDelaySeconds = params.irPreDelay->load() / 1000.0f;
+    convolution.setEdits(edits);
+}
+
+void BraveLvkaiAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(reportedLatency);
+}
+
 //==============================================================================
 bool BraveLvkaiAudioProcessor::hasEditor() const
 {
@@ -242,8 +255,14 @@ juce::AudioProcessorEditor* BraveLvkaiAudioProcessor::createEditor()
 //==============================================================================
 void BraveLvkaiAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    // The IR is recalled by path; its partitions come back from the IR cache.
+    // The live state belongs to the message thread, and the host may call
+    // this from any thread, so the property goes on a copy.
+    auto state = apvts.copyState();
+    state.setProperty("IRFile", convolution.getImpulseResponseFile().getFullPathName(), nullptr);
+
     juce::MemoryOutputStream stream(destData, false);
-    apvts.state.writeToStream(stream);
+    state.writeToStream(stream);
 }
 
 void BraveLvkaiAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -252,6 +271,11 @@ void BraveLvkaiAudioProcessor::setStateInformation (const void* data, int sizeIn
 
     if (tree.isValid()) {
         apvts.state = tree;
+        updateIREdits();
+
+        const juce::File irFile(apvts.state.getProperty("IRFile").toString());
+        if (irFile.existsAsFile())
+            convolution.loadImpulseResponse(irFile);
     }
 }
 
@@ -277,10 +301,31 @@ juce::AudioProcessorValueTreeState::ParameterLayout BraveLvkaiAudioProcessor::cr
         "Volume",
         NormalisableRange<float>(-20.f, 20.f, 0.1f, 1.f), 0.f));
     layout.add(std::make_unique<juce::AudioParameterInt>("DistortionType", "DistortionType", 1, 5, 1));
+    layout.add(std::make_unique<AudioParameterChoice>(ParameterID{ "Oversampling", 1 },
+        "Oversampling",
+        StringArray{ "1x", "2x", "4x", "8x" }, 2));
+    layout.add(std::make_unique<AudioParameterChoice>(ParameterID{ "Antialiasing", 1 },
+        "Antialiasing",
+        StringArray{ "Off", "ADAA 1st order", "ADAA 2nd order" }, 0));
 
     layout.add(std::make_unique<AudioParameterFloat>(ParameterID{ "RevDryWet", 1 },
         "RevDryWet",
         NormalisableRange<float>(1.f, 100.f, 1.f, 1.f), 100.f));
+    layout.add(std::make_unique<AudioParameterBool>(ParameterID{ "IRReverse", 1 },
+        "IRReverse", false));
+    layout.add(std::make_unique<AudioParameterFloat>(ParameterID{ "IRDecay", 1 },
+        "IRDecay",
+        NormalisableRange<float>(1.f, 100.f, 1.f, 1.f), 100.f));
+    layout.add(std::make_unique<AudioParameterFloat>(ParameterID{ "IRPreDelay", 1 },
+        "IRPreDelay",
+        NormalisableRange<float>(0.f, 200.f, 1.f, 1.f), 0.f));
+
+    layout.add(std::make_unique<AudioParameterBool>(ParameterID{ "MidiOutput", 1 },
+        "MidiOutput", false));
+    // In PitchAnalyser::Algorithm order
+    layout.add(std::make_unique<AudioParameterChoice>(ParameterID{ "PitchAlgorithm", 1 },
+        "PitchAlgorithm",
+        StringArray{ "pYIN", "Autocorrelation", "Sliding Autocorrelation", "MPM" }, 0));
 
     return layout;
 }
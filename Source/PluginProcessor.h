@@ -9,17 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "DSP/NotchFilter.h"
 #include "DSP/Saturation.h"
 #include "DSP/Convolution.h"
 #include "DSP/VocalBox.h"
-#include "DSP/PitchDetector/autoCorrelation.h"
-#include "DSP/PitchDetector/Yin.h"
+#include "DSP/PitchDetector/PitchAnalyser.h"
+#include "DSP/PitchDetector/PitchToMidi.h"
+#include "Utils/Parameters.h"
+#include "Utils/QualityProfile.h"
+#include "Utils/SilenceDetector.h"
 
 //==============================================================================
 /**
 */
-class BraveLvkaiAudioProcessor  : public juce::AudioProcessor
+class BraveLvkaiAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::AsyncUpdater
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -66,12 +69,23 @@ public:
     static APVTS::ParameterLayout createParameterLayout();
 
     APVTS apvts{ *this, nullptr, "Parameters", createParameterLayout() };
+    const ParameterHandles params{ apvts };
 
     Convolution convolution;
 
-    double frequency = 0;
+    // Written on the analysis thread; the editor reads estimates from here too
+    PitchAnalyser pitchAnalyser;
 
 private:
+    // Reports latency changes from the audio thread to the host
+    void handleAsyncUpdate() override;
+    void updateLatency();
+    void updateIREdits();
+
+    std::atomic<int> reportedLatency{ 0 };
+    SilenceDetector inputSilence;
+    PitchToMidi pitchToMidi;
+
     juce::dsp::Convolution convolver;
     juce::AudioBuffer<float> originalIRBuffer;
     juce::AudioBuffer<float> modifiedIRBuffer;
@@ -80,17 +94,8 @@ private:
     double makeUpGain;
 
     Saturation saturation;
-    AutoCorrelation ac;
     VocalBox vocalBox;
 
-    PeakFilter peakFilter;
-
-    Yin::Yin_Pitch yin;
-
-    // juce::AudioBuffer<float> pitchDetectionBuffer{ 1, 512 };
-    float* pitchDetectionBuffer = nullptr;
-    
-    
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BraveLvkaiAudioProcessor)
 };
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    Parameters.h
+    Created: 17 Oct 2026 11:20:41am
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Raw parameter handles, resolved once when the processor is built so that
+// processBlock never looks a parameter up by name
+struct ParameterHandles
+{
+    explicit ParameterHandles(juce::AudioProcessorValueTreeState& apvts)
+        : highPassFreq(get(apvts, "HighPassFreq")),
+          lowPassFreq(get(apvts, "LowPassFreq")),
+          drive(get(apvts, "Drive")),
+          satDryWet(get(apvts, "SatDryWet")),
+          volume(get(apvts, "Volume")),
+          distortionType(get(apvts, "DistortionType")),
+          oversampling(get(apvts, "Oversampling")),
+          antialiasing(get(apvts, "Antialiasing")),
+          revDryWet(get(apvts, "RevDryWet")),
+          irReverse(get(apvts, "IRReverse")),
+          irDecay(get(apvts, "IRDecay")),
+          irPreDelay(get(apvts, "IRPreDelay")),
+          midiOutput(get(apvts, "MidiOutput")),
+          pitchAlgorithm(get(apvts, "PitchAlgorithm"))
+    {
+    }
+
+    std::atomic<float>* const highPassFreq;
+    std::atomic<float>* const lowPassFreq;
+    std::atomic<float>* const drive;
+    std::atomic<float>* const satDryWet;
+    std::atomic<float>* const volume;
+    std::atomic<float>* const distortionType;
+    std::atomic<float>* const oversampling;
+    std::atomic<float>* const antialiasing;
+    std::atomic<float>* const revDryWet;
+    std::atomic<float>* const irReverse;
+    std::atomic<float>* const irDecay;
+    std::atomic<float>* const irPreDelay;
+    std::atomic<float>* const midiOutput;
+    std::atomic<float>* const pitchAlgorithm;
+
+private:
+    static std::atomic<float>* get(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID)
+    {
+        auto* parameter = apvts.getRawParameterValue(parameterID);
+        jassert(parameter != nullptr);
+        return parameter;
+    }
+};
+
+// Smoothing for the continuous parameters, picked here for every module.
+// Gains move multiplicatively (straight lines in dB), mixes linearly.
+namespace ParameterSmoothing
+{
+    constexpr double rampLengthSeconds = 0.05;
+
+    using Gain = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+    using Drive = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+    using Mix = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear>;
+
+    // Writes the next numSamples values of the smoother into ramp and returns
+    // true, or returns false without touching ramp when the value is steady so
+    // the caller can use a scalar multiply instead
+    template <typename Smoother>
+    bool fillRamp(Smoother& smoother, float* ramp, int numSamples) noexcept
+    {
+        if (! smoother.isSmoothing())
+            return false;
+
+        for (int i = 0; i < numSamples; ++i)
+            ramp[i] = smoother.getNextValue();
+
+        return true;
+    }
+
+    // Splits a wet proportion into per-sample wet and dry gains, dry = 1 - wet.
+    // Returns false when it is steady; wetGain and dryGain then hold the scalar gains.
+    template <typename MixSmoother>
+    bool fillMixRamps(MixSmoother& mix, float* wetRamp, float* dryRamp, int numSamples,
+                      float& wetGain, float& dryGain) noexcept
+    {
+        if (! fillRamp(mix, wetRamp, numSamples))
+        {
+            wetGain = mix.getTargetValue();
+            dryGain = 1.0f - wetGain;
+            return false;
+        }
+
+        juce::FloatVectorOperations::negate(dryRamp, wetRamp, numSamples);
+        juce::FloatVectorOperations::add(dryRamp, 1.0f, numSamples);
+        return true;
+    }
+
+    // Splits a gain and a wet proportion into per-sample wet and dry gains,
+    // wet = gain * mix and dry = gain * (1 - mix). Returns false when both are
+    // steady; wetGain and dryGain then hold the scalar gains.
+    template <typename GainSmoother, typename MixSmoother>
+    bool fillMixRamps(GainSmoother& gain, MixSmoother& mix, float* wetRamp, float* dryRamp, int numSamples,
+                      float& wetGain, float& dryGain) noexcept
+    {
+        if (! gain.isSmoothing() && ! mix.isSmoothing())
+        {
+            wetGain = gain.getTargetValue() * mix.getTargetValue();
+            dryGain = gain.getTargetValue() - wetGain;
+            return false;
+        }
+
+        if (! fillRamp(gain, dryRamp, numSamples))
+            juce::FloatVectorOperations::fill(dryRamp, gain.getTargetValue(), numSamples);
+
+        if (fillRamp(mix, wetRamp, numSamples))
+            juce::FloatVectorOperations::multiply(wetRamp, dryRamp, numSamples);
+        else
+            juce::FloatVectorOperations::multiply(wetRamp, dryRamp, mix.getTargetValue(), numSamples);
+
+        juce::FloatVectorOperations::subtract(dryRamp, wetRamp, numSamples);
+        return true;
+    }
+}
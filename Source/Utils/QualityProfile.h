@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    QualityProfile.h
+    Created: 17 Oct 2026 1:42:18pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// DSP settings that trade CPU for quality. The processor picks one in
+// prepareToPlay from isNonRealtime(), so a profile only ever changes between
+// prepareToPlay calls, never while audio is running.
+struct QualityProfile
+{
+    juce::dsp::Oversampling<float>::FilterType oversamplingFilter;
+    bool maxQualityOversampling;
+
+    // Longest impulse response the convolver will run; 0 means no limit
+    double maxIRLengthSeconds;
+
+    // Hop between pitch estimates, in samples
+    int pitchHopSize;
+
+    // Compute the convolution's large partitions a frame ahead on a worker
+    // thread (see TailWorker) instead of in the audio callback
+    bool deferConvolutionTail;
+
+    bool operator== (const QualityProfile& other) const
+    {
+        return oversamplingFilter == other.oversamplingFilter
+            && maxQualityOversampling == other.maxQualityOversampling
+            && maxIRLengthSeconds == other.maxIRLengthSeconds
+            && pitchHopSize == other.pitchHopSize
+            && deferConvolutionTail == other.deferConvolutionTail;
+    }
+
+    bool operator!= (const QualityProfile& other) const { return ! operator== (other); }
+
+    // Live playback: polyphase IIR oversampling, IRs faded out after 4 s,
+    // convolution tail on a worker thread
+    static QualityProfile realtime()
+    {
+        return { juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false, 4.0, 1024, true };
+    }
+
+    // Offline bounce: linear-phase FIR oversampling, full-length IRs, finer
+    // pitch hop; no deadline, so the convolution stays on the calling thread
+    static QualityProfile offline()
+    {
+        return { juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, 0.0, 256, false };
+    }
+
+    static QualityProfile forRenderMode(bool isNonRealtime)
+    {
+        return isNonRealtime ? offline() : realtime();
+    }
+};
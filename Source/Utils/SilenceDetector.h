@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    SilenceDetector.h
+    Created: 17 Oct 2026 9:12:06pm
+    Author:  TaroPie
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Counts how long the processor's input has stayed below the silence
+// threshold, so each module can tell when its own state has run out and it
+// can stop working until sound comes back
+class SilenceDetector
+{
+public:
+    // -120 dBFS; anything quieter is treated as digital silence
+    static constexpr float threshold = 1.0e-6f;
+
+    void reset() noexcept { silentSamples = 0; }
+
+    // Call once per block, before anything changes the block
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept
+    {
+        const auto numSamples = static_cast<int> (block.getNumSamples());
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(block.getChannelPointer(channel), numSamples);
+            if (range.getStart() < -threshold || range.getEnd() > threshold)
+            {
+                silentSamples = 0;
+                return;
+            }
+        }
+
+        silentSamples += numSamples;
+    }
+
+    // Samples since the input last went above the threshold, this block included
+    juce::int64 getSilentSamples() const noexcept { return silentSamples; }
+
+private:
+    juce::int64 silentSamples = 0;
+};